@@ -0,0 +1,36 @@
+#!/bin/sh
+# bench.sh: scanner throughput benchmark run by make bench
+#
+# usage: bench.sh scanner...
+#
+# Scans generated C- inputs of every mix and size with each
+# scanner, tracing off, and prints one CSV row per run:
+# tokens/s, MB/s and allocations per token (MB is 2^20 bytes),
+# with the size of the scanner executable.
+# BENCH_SIZES lists the input sizes in MB, BENCH_MIXES the
+# cmgen mixes; inputs are kept in BENCH_DIR between runs.
+
+sizes=${BENCH_SIZES:-"1 16 256"}
+mixes=${BENCH_MIXES:-"mixed ident number operator comment"}
+dir=${BENCH_DIR:-/tmp/cminus-bench}
+
+mkdir -p "$dir" || exit 1
+echo "scanner,mix,bytes,tokens,seconds,tokens_per_s,mb_per_s,allocations,allocations_per_token,binary_bytes"
+for mix in $mixes; do
+  for mb in $sizes; do
+    input="$dir/$mix-${mb}M.cm"
+    if [ ! -s "$input" ]; then
+      ./cmgen -m "$mix" "${mb}M" > "$input.tmp" && mv "$input.tmp" "$input" || exit 1
+    fi
+    for scanner in "$@"; do
+      LD_PRELOAD=./benchalloc.so ./"$scanner" -s "$input" > "$dir/out" 2> "$dir/err" || exit 1
+      # tokens: N, bytes: N, seconds: S, tokens/s: N, MB/s: N
+      tail -1 "$dir/out" | tr -d ',' | awk -v scanner="$scanner" -v mix="$mix" \
+        -v allocs="$(sed -n 's/^allocations: //p' "$dir/err")" \
+        -v binary="$(wc -c < "$scanner")" \
+        '{ printf "%s,%s,%s,%s,%s,%s,%s,%d,%.6f,%d\n", scanner, mix, $4, $2, $6, $8, $10,
+                  allocs, ($2 > 0 ? allocs / $2 : 0), binary }'
+    done
+  done
+done
+rm -f "$dir/out" "$dir/err"
@@ -0,0 +1,37 @@
+/****************************************************/
+/* File: benchalloc.c                               */
+/* Allocation counter for make bench                */
+/* Preloaded into a scanner, it counts the calls of */
+/* malloc, calloc and realloc and prints the count  */
+/* on standard error when the scanner exits         */
+/****************************************************/
+
+#include <stdio.h>
+#include <stddef.h>
+
+/* the allocator of the C library (glibc) */
+extern void * __libc_malloc(size_t);
+extern void * __libc_calloc(size_t, size_t);
+extern void * __libc_realloc(void *, size_t);
+
+static long allocations = 0;
+
+void * malloc(size_t size)
+{ __sync_fetch_and_add(&allocations,1);
+  return __libc_malloc(size);
+}
+
+void * calloc(size_t n, size_t size)
+{ __sync_fetch_and_add(&allocations,1);
+  return __libc_calloc(n,size);
+}
+
+void * realloc(void * p, size_t size)
+{ __sync_fetch_and_add(&allocations,1);
+  return __libc_realloc(p,size);
+}
+
+__attribute__((destructor))
+static void report(void)
+{ fprintf(stderr,"allocations: %ld\n",allocations);
+}
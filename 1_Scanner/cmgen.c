@@ -0,0 +1,282 @@
+/****************************************************/
+/* File: cmgen.c                                    */
+/* Generator of C- benchmark inputs for make bench  */
+/* Writes valid C- functions to standard output     */
+/* until the requested size is reached. The text    */
+/* only depends on the mix and the seed, so every   */
+/* run of the benchmark scans the same input        */
+/****************************************************/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Mix sets the proportions of the generated tokens */
+typedef struct
+   { const char * name;
+     int idLen; /* length of identifiers */
+     int numPct; /* percent of operands that are numbers */
+     int opsMax; /* most operators in an expression */
+     int commentPct; /* percent of statements after a comment */
+     int commentLen; /* words in a comment */
+   } Mix;
+
+static const Mix mixes[] =
+   { {"mixed",6,30,4,10,8},
+     {"ident",16,5,2,2,4},
+     {"number",2,80,4,2,4},
+     {"operator",1,30,12,2,4},
+     {"comment",6,30,3,60,24} };
+#define NMIXES (sizeof(mixes)/sizeof(mixes[0]))
+
+/* NLOCALS is the number of scalar locals of a function,
+   which also gets an int and an array parameter; names
+   are numbered locals first, then the array, then the int */
+#define NLOCALS 7
+#define ASIZE 10
+/* MAXDEPTH bounds the nesting of statements and calls */
+#define MAXDEPTH 3
+
+static const Mix * mix;
+static unsigned long long seed = 2018008013;
+static long long written; /* bytes written so far */
+
+/* nextRandom returns the next number of an xorshift
+   generator, the same on every platform */
+static unsigned nextRandom(void)
+{ seed ^= seed << 13;
+  seed ^= seed >> 7;
+  seed ^= seed << 17;
+  return (unsigned) (seed >> 32);
+}
+
+/* chance is TRUE pct percent of the time */
+static int chance(int pct)
+{ return (int) (nextRandom() % 100) < pct;
+}
+
+static void emit(const char * fmt, ...)
+{ va_list ap;
+  va_start(ap,fmt);
+  written += vprintf(fmt,ap);
+  va_end(ap);
+}
+
+static void indent(int depth)
+{ emit("%*s",2*depth,"");
+}
+
+/* putName writes identifier i of a kind: letters of
+   word up to the length of the mix, then a capital
+   that numbers it, so names never clash with the
+   reserved words */
+static void putName(const char * word, int i)
+{ int k, n = strlen(word);
+  for (k = 0; k < mix->idLen - 1; k++)
+    emit("%c",word[k % n]);
+  emit("%c",'A' + i);
+}
+
+/* putFnName writes the name of function i */
+static void putFnName(int i)
+{ putName("function",0);
+  do
+  { emit("%c",'A' + i % 26);
+    i /= 26;
+  } while (i > 0);
+}
+
+static void putComment(int depth)
+{ static const char * words[] =
+     { "the","loop","keeps","an","invariant","over","values","of",
+       "index","sum","while","checking","array","bounds","here" };
+  int k;
+  indent(depth);
+  emit("/*");
+  for (k = 0; k < mix->commentLen; k++)
+  { if (k > 0 && k % 8 == 0)
+    { emit("\n");
+      indent(depth);
+      emit("  ");
+    }
+    else
+      emit(" ");
+    emit("%s",words[nextRandom() % (sizeof(words)/sizeof(words[0]))]);
+  }
+  emit(" */\n");
+}
+
+static void putExpr(int fn, int depth);
+
+/* putOperand writes a number, a variable, an array
+   element or a call */
+static void putOperand(int fn, int depth)
+{ unsigned r = nextRandom() % 16;
+  if (chance(mix->numPct))
+    emit("%u",nextRandom() % 1000);
+  else if (r < 2 && depth < MAXDEPTH)
+  { putName("value",NLOCALS);
+    emit("[");
+    putExpr(fn,depth+1);
+    emit("]");
+  }
+  else if (r < 3 && depth < MAXDEPTH)
+  { putFnName(nextRandom() % (fn + 1));
+    emit("(");
+    putExpr(fn,depth+1);
+    emit(", ");
+    putName("value",NLOCALS);
+    emit(")");
+  }
+  else if (r < 5 && depth < MAXDEPTH)
+  { emit("(");
+    putExpr(fn,depth+1);
+    emit(")");
+  }
+  else if (r < 7)
+    putName("arg",NLOCALS+1);
+  else
+    putName("value",nextRandom() % NLOCALS);
+}
+
+static void putExpr(int fn, int depth)
+{ static const char * ops[] = { " + "," - "," * "," / " };
+  int k, n = nextRandom() % (mix->opsMax + 1);
+  putOperand(fn,depth);
+  for (k = 0; k < n; k++)
+  { emit("%s",ops[nextRandom() % 4]);
+    putOperand(fn,depth);
+  }
+}
+
+static void putCondition(int fn, int depth)
+{ static const char * relops[] = { " < "," <= "," > "," >= "," == "," != " };
+  putExpr(fn,depth);
+  emit("%s",relops[nextRandom() % 6]);
+  putExpr(fn,depth);
+}
+
+static void putStmt(int fn, int depth);
+
+static void putBlock(int fn, int depth)
+{ int k, n = 1 + nextRandom() % 3;
+  emit("{\n");
+  for (k = 0; k < n; k++)
+    putStmt(fn,depth+1);
+  indent(depth);
+  emit("}\n");
+}
+
+static void putStmt(int fn, int depth)
+{ unsigned r = nextRandom() % 8;
+  if (chance(mix->commentPct))
+    putComment(depth);
+  indent(depth);
+  if (r < 1 && depth < MAXDEPTH)
+  { emit("if (");
+    putCondition(fn,depth);
+    emit(") ");
+    putBlock(fn,depth);
+    if (chance(50))
+    { indent(depth);
+      emit("else ");
+      putBlock(fn,depth);
+    }
+  }
+  else if (r < 2 && depth < MAXDEPTH)
+  { emit("while (");
+    putCondition(fn,depth);
+    emit(") ");
+    putBlock(fn,depth);
+  }
+  else
+  { if (r < 4)
+    { putName("value",NLOCALS);
+      emit("[%u]",nextRandom() % ASIZE);
+    }
+    else
+      putName("value",nextRandom() % NLOCALS);
+    emit(" = ");
+    putExpr(fn,depth);
+    emit(";\n");
+  }
+}
+
+/* putFunction writes function fn, which may call
+   itself and the functions before it */
+static void putFunction(int fn)
+{ int k, n = 2 + nextRandom() % 8;
+  if (chance(mix->commentPct))
+    putComment(0);
+  emit("int ");
+  putFnName(fn);
+  emit("(int ");
+  putName("arg",NLOCALS+1);
+  emit(", int ");
+  putName("value",NLOCALS);
+  emit("[])\n{ ");
+  for (k = 0; k < NLOCALS; k++)
+  { emit("int ");
+    putName("value",k);
+    emit("; ");
+  }
+  emit("\n");
+  for (k = 0; k < n; k++)
+    putStmt(fn,1);
+  emit("  return ");
+  putExpr(fn,1);
+  emit(";\n}\n\n");
+}
+
+/* parseSize reads a size with an optional K, M or G
+   suffix; returns -1 if it is not one */
+static long long parseSize(const char * arg)
+{ char * end;
+  long long size = strtoll(arg,&end,10);
+  if (end == arg || size < 0)
+    return -1;
+  switch (*end)
+  { case 'K': case 'k': size <<= 10; end++; break;
+    case 'M': case 'm': size <<= 20; end++; break;
+    case 'G': case 'g': size <<= 30; end++; break;
+    default: break;
+  }
+  return *end == '\0' ? size : -1;
+}
+
+int main(int argc, char * argv[])
+{ long long size;
+  int i, fn;
+  mix = &mixes[0];
+  for (i = 1; i + 1 < argc && argv[i][0] == '-'; i += 2)
+  { if (!strcmp(argv[i],"-m"))
+    { int k;
+      for (k = 0; k < NMIXES && strcmp(mixes[k].name,argv[i+1]); k++)
+        ;
+      if (k == NMIXES)
+      { fprintf(stderr,"cmgen: unknown mix %s\n",argv[i+1]);
+        return 1;
+      }
+      mix = &mixes[k];
+    }
+    else if (!strcmp(argv[i],"-r"))
+      seed = strtoull(argv[i+1],NULL,10) | 1;
+    else
+      break;
+  }
+  if (i + 1 != argc || (size = parseSize(argv[i])) < 0)
+  { fprintf(stderr,"usage: %s [-m mix] [-r seed] <size>[K|M|G]\n",argv[0]);
+    fprintf(stderr,"mixes:");
+    for (i = 0; i < NMIXES; i++)
+      fprintf(stderr," %s",mixes[i].name);
+    fprintf(stderr,"\n");
+    return 1;
+  }
+  /* the functions stop at the first one past the size,
+     main is kept last as C- requires */
+  for (fn = 0; written < size; fn++)
+    putFunction(fn);
+  emit("void main(void)\n{ }\n");
+  return ferror(stdout) ? 1 : 0;
+}
@@ -13,6 +13,7 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <string.h>
+#include "srcmap.h"
 
 #ifndef FALSE
 #define FALSE 0
@@ -36,7 +37,7 @@ typedef enum
     ASSIGN,EQ,NE,LT,LE,GT,GE,PLUS,MINUS,TIMES,OVER,LPAREN,RPAREN,LBRACE,RBRACE,LCURLY,RCURLY,SEMI,COMMA
    } TokenType;
 
-extern FILE* source; /* source code text file */
+extern SourceMap* source; /* source code text */
 extern FILE* listing; /* listing output text file */
 extern FILE* code; /* code text file for TM simulator */
 
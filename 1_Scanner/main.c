@@ -6,6 +6,9 @@
 /****************************************************/
 
 #include "globals.h"
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
 
 /* set NO_PARSE to TRUE to get a scanner-only compiler */
 #define NO_PARSE TRUE
@@ -32,7 +35,7 @@
 
 /* allocate global variables */
 int lineno = 0;
-FILE * source;
+SourceMap * source;
 FILE * listing;
 FILE * code;
 
@@ -45,17 +48,194 @@ int TraceCode = FALSE;
 
 int Error = FALSE;
 
+/* fileName copies a source file name into pgm,
+ * adding the default extension
+ */
+static void fileName(char * pgm, const char * arg)
+{ strcpy(pgm,arg) ;
+  if (strchr (pgm, '.') == NULL)
+     strcat(pgm,".tny");
+}
+
+#if NO_PARSE
+/* processors returns the number of processors online */
+static int processors(void)
+{ long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+  return ncpu < 1 ? 1 : ncpu;
+}
+
+/* reportSpeed prints the number of tokens and bytes
+ * scanned between start and end and the throughput,
+ * in the form read by bench.sh
+ */
+static void reportSpeed(FILE * out, long tokens, long bytes,
+                        struct timespec * start, struct timespec * end)
+{ double secs = (end->tv_sec - start->tv_sec)
+              + (end->tv_nsec - start->tv_nsec) / 1e9;
+  fprintf(out,"tokens: %ld, bytes: %ld, seconds: %.6f, tokens/s: %.0f, MB/s: %.2f\n",
+          tokens,bytes,secs,secs > 0 ? tokens / secs : 0.0,
+          secs > 0 ? bytes / secs / (1 << 20) : 0.0);
+}
+
+/* scanSpeed scans the whole source of s without
+ * tracing and reports the number of tokens and
+ * the throughput
+ */
+static void scanSpeed(Scanner * s)
+{ struct timespec start, end;
+  long tokens = 1; /* counting the final ENDFILE */
+  s->echo = FALSE;
+  s->trace = FALSE;
+  clock_gettime(CLOCK_MONOTONIC,&start);
+  while (scanToken(s)!=ENDFILE) tokens++;
+  clock_gettime(CLOCK_MONOTONIC,&end);
+  reportSpeed(s->listing,tokens,s->source->size,&start,&end);
+}
+
+/* scanChunked scans the source of s in chunks on
+ * all processors, then prints the listing of s or,
+ * with speed, the throughput
+ */
+static void scanChunked(Scanner * s, int speed)
+{ struct timespec start, end;
+  TokenStream * ts;
+  clock_gettime(CLOCK_MONOTONIC,&start);
+  ts = scanParallel(s->source,processors());
+  clock_gettime(CLOCK_MONOTONIC,&end);
+  if (ts == NULL)
+  { fprintf(stderr,"Out of memory\n");
+    exit(1);
+  }
+  if (speed)
+    reportSpeed(s->listing,ts->count,s->source->size,&start,&end);
+  else
+    listTokens(s,ts);
+  freeTokenStream(ts);
+}
+
+/* ScanJob is one source file of a batch; its
+ * listing is kept in memory until all are done
+ */
+typedef struct
+   { char pgm[120]; /* source code file name */
+     int speed; /* report speed instead of tracing */
+     int failed; /* file could not be scanned */
+     char * text; /* listing of the file */
+     size_t size;
+   } ScanJob;
+
+static ScanJob * jobs;
+static int njobs;
+static int nextJob = 0; /* next job to hand to a worker */
+
+/* scanJob scans one file with its own scanner */
+static void scanJob(ScanJob * job)
+{ SourceMap * src = srcmap_open(job->pgm);
+  FILE * out;
+  Scanner * s;
+  if (src == NULL)
+  { job->failed = TRUE;
+    return;
+  }
+  out = open_memstream(&job->text,&job->size);
+  s = out ? newScanner(src,out) : NULL;
+  if (s == NULL)
+    job->failed = TRUE;
+  else
+  { fprintf(out,"C-MINUS COMPILATION: %s\n",job->pgm);
+    if (job->speed)
+      scanSpeed(s);
+    else
+      while (scanToken(s)!=ENDFILE);
+    freeScanner(s);
+  }
+  if (out) fclose(out);
+  srcmap_close(src);
+}
+
+/* scanWorker takes jobs until none are left */
+static void * scanWorker(void * arg)
+{ int i;
+  while ((i = __sync_fetch_and_add(&nextJob,1)) < njobs)
+    scanJob(&jobs[i]);
+  return NULL;
+}
+
+/* scanFiles scans every file on its own thread,
+ * using as many threads as there are processors,
+ * and prints the listings in the order given;
+ * returns the exit status
+ */
+static int scanFiles(int nfiles, char * files[], int speed)
+{ int nthreads = processors();
+  pthread_t * threads = malloc(nthreads * sizeof(pthread_t));
+  int i, started = 0, status = 0;
+  jobs = calloc(nfiles, sizeof(ScanJob));
+  if (jobs == NULL || threads == NULL)
+  { fprintf(stderr,"Out of memory\n");
+    return 1;
+  }
+  njobs = nfiles;
+  if (nthreads > nfiles) nthreads = nfiles;
+  for (i = 0; i < nfiles; i++)
+  { fileName(jobs[i].pgm,files[i]);
+    jobs[i].speed = speed;
+  }
+  for (i = 0; i < nthreads; i++)
+    if (pthread_create(&threads[started],NULL,scanWorker,NULL) == 0)
+      started++;
+  /* without any thread, scan here */
+  if (started == 0)
+    scanWorker(NULL);
+  for (i = 0; i < started; i++)
+    pthread_join(threads[i],NULL);
+  for (i = 0; i < nfiles; i++)
+  { if (jobs[i].failed)
+    { fprintf(stderr,"File %s not found\n",jobs[i].pgm);
+      status = 1;
+    }
+    else
+      fwrite(jobs[i].text,1,jobs[i].size,listing);
+    free(jobs[i].text);
+  }
+  free(jobs);
+  free(threads);
+  return status;
+}
+#endif
+
 main( int argc, char * argv[] )
 { TreeNode * syntaxTree;
   char pgm[120]; /* source code file name */
-  if (argc != 2)
-    { fprintf(stderr,"usage: %s <filename>\n",argv[0]);
+  int speed = FALSE; /* -s: report scanning speed instead of tracing */
+  int chunked = FALSE; /* -p: scan one file in chunks on all processors */
+  char * prog = argv[0];
+  while (argc >= 3 && argv[1][0] == '-')
+  { if (!strcmp(argv[1],"-s"))
+    { speed = TRUE;
+      EchoSource = FALSE;
+      TraceScan = FALSE;
+    }
+    else if (!strcmp(argv[1],"-p"))
+      chunked = TRUE;
+    else
+      break;
+    argv++;
+    argc--;
+  }
+  if (argc < 2 || (chunked && argc > 2))
+    { fprintf(stderr,"usage: %s [-s] <filename>...\n"
+                     "       %s [-s] -p <filename>\n",prog,prog);
       exit(1);
     }
-  strcpy(pgm,argv[1]) ;
-  if (strchr (pgm, '.') == NULL)
-     strcat(pgm,".tny");
-  source = fopen(pgm,"r");
+#if NO_PARSE
+  if (argc > 2)
+  { listing = stdout;
+    return scanFiles(argc-1,argv+1,speed);
+  }
+#endif
+  fileName(pgm,argv[1]);
+  source = srcmap_open(pgm);
   if (source==NULL)
   { fprintf(stderr,"File %s not found\n",pgm);
     exit(1);
@@ -63,7 +243,20 @@ main( int argc, char * argv[] )
   listing = stdout; /* send listing to screen */
   fprintf(listing,"\C-MINUS COMPILATION: %s\n",pgm);
 #if NO_PARSE
-  while (getToken()!=ENDFILE);
+  if (speed || chunked)
+  { Scanner * s = newScanner(source,listing);
+    if (s == NULL)
+    { fprintf(stderr,"Out of memory\n");
+      exit(1);
+    }
+    if (chunked)
+      scanChunked(s,speed);
+    else
+      scanSpeed(s);
+    freeScanner(s);
+  }
+  else
+    while (getToken()!=ENDFILE);
 #else
   syntaxTree = parse();
   if (TraceParse) {
@@ -96,7 +289,7 @@ main( int argc, char * argv[] )
 #endif
 #endif
 #endif
-  fclose(source);
+  srcmap_close(source);
   return 0;
 }
 
@@ -1,6 +1,9 @@
 /****************************************************/
 /* File: scan.c                                     */
 /* The scanner implementation for the TINY compiler */
+/* Table-driven version: the DFA, its character     */
+/* classes and the keyword hash are generated by    */
+/* scangen into scantab.h                           */
 /* Compiler Construction: Principles and Practice   */
 /* Kenneth C. Louden                                */
 /****************************************************/
@@ -8,270 +11,214 @@
 #include "globals.h"
 #include "util.h"
 #include "scan.h"
-
-/* states in scanner DFA */
-typedef enum
-   { START,INCOMMENT,INNUM,INID,DONE,INLT,INGT,INEQ,INNE,INOVER,INCOMMENT_ }
-   StateType;
+#include "scantab.h"
+#include "skip.h"
 
 /* lexeme of identifier or reserved word */
-char tokenString[MAXTOKENLEN+1];
+TokenSlice tokenSlice;
 
-/* BUFLEN = length of the input buffer for
-   source code lines */
-#define BUFLEN 256
+/* scanToken stops at the limit of a scanner */
+const int canScanChunks = TRUE;
 
-static char lineBuf[BUFLEN]; /* holds the current line */
-static int linepos = 0; /* current position in LineBuf */
-static int bufsize = 0; /* current size of buffer string */
-static int EOF_flag = FALSE; /* corrects ungetNextChar behavior on EOF */
+/* echoLine prints the source line starting at pos */
+static void echoLine(Scanner * s, int pos)
+{ SourceMap * src = s->source;
+  char * nl = memchr(src->text + pos, '\n', src->size - pos);
+  int end = nl ? nl - src->text + 1 : src->size;
+  fprintf(s->listing,"%4d: %.*s",srcmap_line(src,pos),end - pos,src->text + pos);
+}
 
-/* getNextChar fetches the next non-blank character
-   from lineBuf, reading in a new line if lineBuf is
-   exhausted */
-static int getNextChar(void)
-{ if (!(linepos < bufsize))
-  { lineno++;
-    if (fgets(lineBuf,BUFLEN-1,source))
-    { if (EchoSource) fprintf(listing,"%4d: %s",lineno,lineBuf);
-      bufsize = strlen(lineBuf);
-      linepos = 0;
-      return lineBuf[linepos++];
-    }
-    else
-    { EOF_flag = TRUE;
-      return EOF;
-    }
+/* echoSource echoes the lines begun before end.
+   The scanner used to echo a line as soon as it
+   consumed the newline before it, so the lines
+   begun before a token ends come before its trace */
+static void echoSource(Scanner * s, int end)
+{ SourceMap * src = s->source;
+  const char * nl;
+  if (s->echoed < 0)
+  { if (src->size > 0) echoLine(s,0);
+    s->echoed = 0;
   }
-  else return lineBuf[linepos++];
+  while ((nl = memchr(src->text + s->echoed, '\n', end - s->echoed)) != NULL)
+  { s->echoed = nl - src->text + 1;
+    if (s->echoed < src->size) echoLine(s,s->echoed);
+  }
+  s->echoed = end;
 }
 
-/* ungetNextChar backtracks one character
-   in lineBuf */
-static void ungetNextChar(void)
-{ if (!EOF_flag) linepos-- ;}
-
-/* lookup table of reserved words */
-static struct
-    { char* str;
-      TokenType tok;
-    } reservedWords[MAXRESERVED]
-   = {{"if",IF},{"else",ELSE},{"while",WHILE},{"return",RETURN},
-      {"int",INT},{"void",VOID}};
-
 /* lookup an identifier to see if it is a reserved word */
-/* uses linear search */
-static TokenType reservedLookup (char * s)
-{ int i;
-  for (i=0;i<MAXRESERVED;i++)
-    if (!strcmp(s,reservedWords[i].str))
-      return reservedWords[i].tok;
+/* uses the perfect hash generated by scangen */
+static TokenType reservedLookup (const char * str, int length)
+{ int h = KWHASH(length,str[0],str[length-1]);
+  if (keywordTable[h].len == length &&
+      !memcmp(str,keywordTable[h].str,length))
+    return keywordTable[h].tok;
   return ID;
 }
 
+/* Function newScanner returns a scanner over src */
+Scanner * newScanner(SourceMap * src, FILE * out)
+{ Scanner * s = (Scanner *) malloc(sizeof(Scanner));
+  if (s == NULL)
+    return NULL;
+  s->source = src;
+  s->listing = out;
+  s->echo = EchoSource;
+  s->trace = TraceScan;
+  s->lexeme.offset = 0;
+  s->lexeme.length = 0;
+  s->pos = 0;
+  s->limit = src->size;
+  s->inComment = FALSE;
+  s->eofCount = 0;
+  s->echoed = -1;
+  s->yyscanner = NULL;
+  return s;
+}
+
+/* Procedure freeScanner releases a scanner */
+void freeScanner(Scanner * s)
+{ free(s);
+}
+
+/* readsEOF tells whether scanning the lexeme of s
+   reached the end of the source: it ends there and
+   the DFA needed the end as lookahead to accept it */
+static int readsEOF(Scanner * s)
+{ SourceMap * src = s->source;
+  const unsigned char * p = (const unsigned char *) src->text + s->lexeme.offset;
+  const unsigned char * end = p + s->lexeme.length;
+  int state = START;
+  if (s->lexeme.offset + s->lexeme.length != src->size)
+    return FALSE;
+  for (; p < end; p++)
+  { state = transition[state][charClass[*p]];
+    if (state >= ACCEPT)
+      return FALSE;
+  }
+  return TRUE;
+}
+
+/* Function scanLine returns the line of the last token.
+   Every visit to the end of the source starts a new
+   line number, except the first one after a final
+   newline, which already began the line of the end */
+int scanLine(Scanner * s)
+{ SourceMap * src = s->source;
+  int line = srcmap_line(src,s->lexeme.offset);
+  if (s->eofCount > 0)
+  { line += s->eofCount - 1;
+    if (src->size > 0 && src->text[src->size-1] != '\n')
+      line++;
+  }
+  return line;
+}
+
+/* showToken prints the echo and the trace of the last token */
+static void showToken(Scanner * s, TokenType token)
+{ char lexeme[MAXTOKENLEN+1];
+  if (s->echo)
+    echoSource(s,s->lexeme.offset + s->lexeme.length);
+  if (s->trace)
+  { fprintf(s->listing,"\t%d: ",scanLine(s));
+    fprintToken(s->listing,token,
+                srcmap_text(s->source,s->lexeme,lexeme,sizeof(lexeme)));
+  }
+}
+
+/* Procedure listToken prints the listing of a token */
+void listToken(Scanner * s, TokenType token)
+{ if (readsEOF(s))
+    s->eofCount++;
+  showToken(s,token);
+}
+
 /****************************************/
 /* the primary function of the scanner  */
 /****************************************/
-/* function getToken returns the 
- * next token in source file
+/* function scanToken returns the
+ * next token of the scanner s
  */
-TokenType getToken(void)
-{  /* index for storing into tokenString */
-   int tokenStringIndex = 0;
+TokenType scanToken(Scanner * s)
+{  SourceMap * src = s->source;
+   const unsigned char * text = (const unsigned char *) src->text;
+   int limit = s->limit;
+   const char * end = src->text + limit;
+   const char * skipped;
+   /* position of the next character */
+   int pos = s->pos;
+   /* start of the lexeme, moved past blanks and comments */
+   int start = pos;
    /* holds current token to be returned */
    TokenType currentToken;
    /* current state - always begins at START */
    StateType state = START;
-   /* flag to indicate save to tokenString */
-   int save;
-   while (state != DONE)
-   { int c = getNextChar();
-     save = TRUE;
-     switch (state)
-     { case START:
-         if (isdigit(c))
-           state = INNUM;
-         else if (isalpha(c))
-           state = INID;
-         else if (c == '=')
-           state = INEQ;
-         else if (c == '!')
-           state = INNE;
-         else if (c == '<')
-           state = INLT;
-         else if (c == '>')
-           state = INGT;
-         else if (c == '/')
-         { save = FALSE;
-           state = INOVER;
-         }
-         else if ((c == ' ') || (c == '\t') || (c == '\n'))
-           save = FALSE;
-         else
-         { state = DONE;
-           switch (c)
-           { case EOF:
-               save = FALSE;
-               currentToken = ENDFILE;
-               break;
-            //  case '=':
-            //    currentToken = ASSIGN;
-            //    break;
-            //  case '<':
-            //    currentToken = LT;
-            //    break;
-            //  case '>':
-            //    currentToken = GT;
-            //    break;
-             case '+':
-               currentToken = PLUS;
-               break;
-             case '-':
-               currentToken = MINUS;
-               break;
-             case '*':
-               currentToken = TIMES;
-               break;
-            //  case '/':
-            //    currentToken = OVER;
-            //    break;
-             case '(':
-               currentToken = LPAREN;
-               break;
-             case ')':
-               currentToken = RPAREN;
-               break;
-             case '{':
-               currentToken = LCURLY;
-               break;
-             case '}':
-               currentToken = RCURLY;
-               break;
-             case '[':
-               currentToken = LBRACE;
-               break;
-             case ']':
-               currentToken = RBRACE;
-               break;
-             case ';':
-               currentToken = SEMI;
-               break;
-             case ',':
-               currentToken = COMMA;
-               break;
-             default:
-               currentToken = ERROR;
-               break;
-           }
-         }
-         break;
-       case INCOMMENT:
-         save = FALSE;
-         if (c == EOF)
-         { state = DONE;
-           currentToken = ENDFILE;
-         }
-         else if (c == '*') state = INCOMMENT_;
-         break;
-       case INCOMMENT_:
-         save = FALSE;
-         if (c == EOF)
-         { state = DONE;
-           currentToken = ENDFILE;
-         }
-         else if (c == '/') state = START;
-         else if (c != '*') state = INCOMMENT;
-         break;
-       case INOVER:
-         if (c == '*')
-         { save = FALSE;
-           state = INCOMMENT;
-         }
-         else
-         { state = DONE;
-           ungetNextChar();
-           currentToken = OVER;
-           c = '/';
-         }
-         break;
-       case INEQ:
-         state = DONE;
-         if (c == '=')
-           currentToken = EQ;
-         else
-         { /* backup in the input */
-           ungetNextChar();
-           save = FALSE;
-           currentToken = ASSIGN;
-         }
-         break;
-       case INNE:
-         state = DONE;
-         if (c == '=')
-           currentToken = NE;
-         else
-         { ungetNextChar();
-           save = FALSE;
-           currentToken = ERROR;
-         }
-         break;
-       case INGT:
-         state = DONE;
-         if (c == '=')
-           currentToken = GE;
-         else
-         { ungetNextChar();
-           save = FALSE;
-           currentToken = GT;
-         }
-         break;
-       case INLT:
-         state = DONE;
-         if (c == '=')
-           currentToken = LE;
-         else
-         { ungetNextChar();
-           save = FALSE;
-           currentToken = LT;
-         }
-         break;
-       case INNUM:
-         if (!isdigit(c))
-         { /* backup in the input */
-           ungetNextChar();
-           save = FALSE;
-           state = DONE;
-           currentToken = NUM;
-         }
-         break;
-       case INID:
-         if (!isalpha(c))
-         { /* backup in the input */
-           ungetNextChar();
-           save = FALSE;
-           state = DONE;
-           currentToken = ID;
-         }
-         break;
-       case DONE:
-       default: /* should never happen */
-         fprintf(listing,"Scanner Bug: state= %d\n",state);
-         state = DONE;
-         currentToken = ERROR;
-         break;
+   int cls, next;
+   while (TRUE)
+   { cls = pos < limit ? charClass[text[pos]] : CC_EOF;
+     next = transition[state][cls];
+     if (next >= ACCEPT)
+       break;
+     if (state == START)
+     { start = pos;
+       if (cls == CC_NEWLINE)
+       { /* indentation and blank lines in one step */
+         pos = skipBlanks(src->text + pos + 1, end) - src->text;
+         continue;
+       }
      }
-     if ((save) && (tokenStringIndex <= MAXTOKENLEN))
-       tokenString[tokenStringIndex++] = (char) c;
-     if (state == DONE)
-     { tokenString[tokenStringIndex] = '\0';
-       if (currentToken == ID)
-         currentToken = reservedLookup(tokenString);
+     pos++;
+     state = next;
+     if (state == INCOMMENT)
+     { skipped = skipComment(src->text + pos, end);
+       if (skipped != NULL)
+       { pos = skipped - src->text;
+         state = START;
+       }
+       else
+         pos = limit;
      }
    }
-   if (TraceScan) {
-     fprintf(listing,"\t%d: ",lineno);
-     printToken(currentToken,tokenString);
+   s->inComment = state == INCOMMENT || state == INCOMMENT_;
+   if (state == START)
+     start = pos;
+   if (next >= BACKUP)
+     currentToken = next - BACKUP;
+   else
+   { currentToken = next - ACCEPT;
+     pos++;
    }
+   if (cls == CC_EOF)
+     s->eofCount++;
+   if (currentToken == ENDFILE)
+     start = pos;
+   s->pos = pos;
+   s->lexeme.offset = start;
+   s->lexeme.length = pos - start;
+   if (currentToken == ID)
+     currentToken = reservedLookup(src->text + start, pos - start);
+   if (s->echo || s->trace)
+     showToken(s,currentToken);
    return currentToken;
-} /* end getToken */
+} /* end scanToken */
+
+/* the scanner used by getToken */
+static Scanner * globalScanner = NULL;
 
+/* function getToken returns the next token
+ * of source, keeping lineno and tokenSlice
+ */
+TokenType getToken(void)
+{ TokenType currentToken;
+  if (globalScanner == NULL)
+  { globalScanner = newScanner(source,listing);
+    if (globalScanner == NULL)
+    { fprintf(listing,"Out of memory error at line %d\n",lineno);
+      return ENDFILE;
+    }
+  }
+  currentToken = scanToken(globalScanner);
+  lineno = scanLine(globalScanner);
+  tokenSlice = globalScanner->lexeme;
+  return currentToken;
+} /* end getToken */
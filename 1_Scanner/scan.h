@@ -8,11 +8,93 @@
 #ifndef _SCAN_H_
 #define _SCAN_H_
 
-/* MAXTOKENLEN is the maximum size of a token */
+/* MAXTOKENLEN is the maximum size of a traced lexeme */
 #define MAXTOKENLEN 40
 
-/* tokenString array stores the lexeme of each token */
-extern char tokenString[MAXTOKENLEN+1];
+/* tokenSlice locates the lexeme of the last token
+ * inside the source map; lexemes are not copied
+ */
+extern TokenSlice tokenSlice;
+
+/* Scanner holds all the state of one scan, so that
+ * several sources can be scanned at the same time,
+ * each by its own thread; only getToken uses the
+ * globals source, listing, lineno and tokenSlice.
+ * Only byte offsets are kept while scanning; line
+ * numbers come from the line index of the source
+ * map when the listing or getToken asks for them.
+ */
+typedef struct
+   { SourceMap * source; /* text being scanned */
+     FILE * listing; /* receives the echo and the trace */
+     int echo; /* echo each source line, as EchoSource */
+     int trace; /* print each token, as TraceScan */
+     TokenSlice lexeme; /* lexeme of the last token */
+     int pos; /* next character (scan.c) */
+     int limit; /* end of the text to scan (scan.c) */
+     int inComment; /* the scan ended inside a comment (scan.c) */
+     int eofCount; /* visits to the end of the source (scan.c) */
+     int echoed; /* end of the echoed source, -1 before the first
+                    line (scan.c) */
+     void * yyscanner; /* reentrant flex state (cminus.l) */
+   } Scanner;
+
+/* Function newScanner returns a scanner over src
+ * writing to out, with echo and trace taken from
+ * EchoSource and TraceScan; NULL if out of memory
+ */
+Scanner * newScanner(SourceMap * src, FILE * out);
+
+/* Function scanToken returns the next token
+ * of the scanner s
+ */
+TokenType scanToken(Scanner * s);
+
+/* Procedure freeScanner releases a scanner */
+void freeScanner(Scanner * s);
+
+/* Function scanLine returns the source line
+ * of the last token of s
+ */
+int scanLine(Scanner * s);
+
+/* Procedure listToken prints the echo and the
+ * trace of a token of the source of s, put in
+ * s->lexeme, as if s had just scanned it
+ */
+void listToken(Scanner * s, TokenType token);
+
+/* TokenStream holds every token of the source
+ * in struct-of-arrays form, ending with ENDFILE
+ */
+typedef struct
+   { int count;
+     int capacity;
+     TokenType * kind;
+     int * offset; /* start of the lexeme in the source map */
+     int * length; /* length of the lexeme */
+   } TokenStream;
+
+/* canScanChunks is TRUE when scanToken honours the
+ * pos and limit of a scanner, so that a source can
+ * be scanned in pieces; flex always takes it whole
+ */
+extern const int canScanChunks;
+
+/* Function scanParallel scans src in chunks on
+ * up to nthreads threads and returns the same
+ * tokens as scanning it with getToken; NULL if
+ * out of memory
+ */
+TokenStream * scanParallel(SourceMap * src, int nthreads);
+
+/* Procedure listTokens prints the listing that
+ * the scanner s prints, from its token stream
+ */
+void listTokens(Scanner * s, TokenStream * ts);
+
+/* Procedure freeTokenStream releases a token stream */
+void freeTokenStream(TokenStream *);
 
 /* function getToken returns the 
  * next token in source file
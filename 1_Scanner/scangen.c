@@ -0,0 +1,227 @@
+/****************************************************/
+/* File: scangen.c                                  */
+/* Generator of the C- scanner tables               */
+/* Prints scantab.h: the character-class map, the   */
+/* DFA transition table and the keyword hash table  */
+/* used by the table-driven scanner in scan.c       */
+/****************************************************/
+
+#include "globals.h"
+
+/* states in scanner DFA */
+static const char * stateNames[] =
+   { "START","INCOMMENT","INNUM","INID","DONE","INLT","INGT",
+     "INEQ","INNE","INOVER","INCOMMENT_" };
+typedef enum
+   { START,INCOMMENT,INNUM,INID,DONE,INLT,INGT,INEQ,INNE,INOVER,INCOMMENT_,
+     NSTATES }
+   StateType;
+
+/* character classes */
+static const char * classNames[] =
+   { "CC_EOF","CC_OTHER","CC_DIGIT","CC_LETTER","CC_BLANK","CC_NEWLINE",
+     "CC_EQ","CC_BANG","CC_LT","CC_GT","CC_SLASH","CC_STAR","CC_PLUS",
+     "CC_MINUS","CC_LPAREN","CC_RPAREN","CC_LBRACE","CC_RBRACE",
+     "CC_LCURLY","CC_RCURLY","CC_SEMI","CC_COMMA" };
+typedef enum
+   { CC_EOF,CC_OTHER,CC_DIGIT,CC_LETTER,CC_BLANK,CC_NEWLINE,
+     CC_EQ,CC_BANG,CC_LT,CC_GT,CC_SLASH,CC_STAR,CC_PLUS,
+     CC_MINUS,CC_LPAREN,CC_RPAREN,CC_LBRACE,CC_RBRACE,
+     CC_LCURLY,CC_RCURLY,CC_SEMI,CC_COMMA,
+     NCLASSES }
+   CharClass;
+
+/* token names, in TokenType order */
+static const char * tokenNames[] =
+   { "ENDFILE","ERROR","IF","ELSE","WHILE","RETURN","INT","VOID",
+     "ID","NUM","ASSIGN","EQ","NE","LT","LE","GT","GE","PLUS","MINUS",
+     "TIMES","OVER","LPAREN","RPAREN","LBRACE","RBRACE","LCURLY","RCURLY",
+     "SEMI","COMMA" };
+
+/* A transition either moves to a state, consuming
+ * the character, or accepts a token. An accepting
+ * transition consumes the character (ACCEPT) or
+ * leaves it for the next token (BACKUP).
+ */
+#define ACCEPT 64
+#define BACKUP 128
+
+static int transition[NSTATES][NCLASSES];
+static int charClass[256];
+
+/* the single-character tokens recognized from START */
+static struct { int c; CharClass cls; TokenType tok; } singles[] =
+   { {'+',CC_PLUS,PLUS},{'-',CC_MINUS,MINUS},{'*',CC_STAR,TIMES},
+     {'(',CC_LPAREN,LPAREN},{')',CC_RPAREN,RPAREN},
+     {'[',CC_LBRACE,LBRACE},{']',CC_RBRACE,RBRACE},
+     {'{',CC_LCURLY,LCURLY},{'}',CC_RCURLY,RCURLY},
+     {';',CC_SEMI,SEMI},{',',CC_COMMA,COMMA} };
+#define NSINGLES (sizeof(singles)/sizeof(singles[0]))
+
+static void buildClasses(void)
+{ int c, i;
+  for (c = 0; c < 256; c++)
+  { if (c >= '0' && c <= '9') charClass[c] = CC_DIGIT;
+    else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+      charClass[c] = CC_LETTER;
+    else charClass[c] = CC_OTHER;
+  }
+  /* the end of the text is found by position, so
+     NUL is an ordinary character; no byte maps to
+     CC_EOF */
+  charClass[' '] = charClass['\t'] = CC_BLANK;
+  charClass['\n'] = CC_NEWLINE;
+  charClass['='] = CC_EQ;
+  charClass['!'] = CC_BANG;
+  charClass['<'] = CC_LT;
+  charClass['>'] = CC_GT;
+  charClass['/'] = CC_SLASH;
+  for (i = 0; i < NSINGLES; i++)
+    charClass[singles[i].c] = singles[i].cls;
+}
+
+/* set every class of state s to the same transition */
+static void fill(StateType s, int t)
+{ int cls;
+  for (cls = 0; cls < NCLASSES; cls++)
+    transition[s][cls] = t;
+}
+
+/* the same DFA as the hand-written scanner of the
+ * previous assignment, one row per state
+ */
+static void buildTransitions(void)
+{ int i;
+  fill(START, ACCEPT + ERROR);
+  transition[START][CC_EOF] = BACKUP + ENDFILE;
+  transition[START][CC_DIGIT] = INNUM;
+  transition[START][CC_LETTER] = INID;
+  transition[START][CC_BLANK] = START;
+  transition[START][CC_NEWLINE] = START;
+  transition[START][CC_EQ] = INEQ;
+  transition[START][CC_BANG] = INNE;
+  transition[START][CC_LT] = INLT;
+  transition[START][CC_GT] = INGT;
+  transition[START][CC_SLASH] = INOVER;
+  for (i = 0; i < NSINGLES; i++)
+    transition[START][singles[i].cls] = ACCEPT + singles[i].tok;
+
+  fill(INCOMMENT, INCOMMENT);
+  transition[INCOMMENT][CC_EOF] = BACKUP + ENDFILE;
+  transition[INCOMMENT][CC_STAR] = INCOMMENT_;
+
+  fill(INCOMMENT_, INCOMMENT);
+  transition[INCOMMENT_][CC_EOF] = BACKUP + ENDFILE;
+  transition[INCOMMENT_][CC_STAR] = INCOMMENT_;
+  transition[INCOMMENT_][CC_SLASH] = START;
+
+  fill(INOVER, BACKUP + OVER);
+  transition[INOVER][CC_STAR] = INCOMMENT;
+
+  fill(INEQ, BACKUP + ASSIGN);
+  transition[INEQ][CC_EQ] = ACCEPT + EQ;
+  fill(INNE, BACKUP + ERROR);
+  transition[INNE][CC_EQ] = ACCEPT + NE;
+  fill(INLT, BACKUP + LT);
+  transition[INLT][CC_EQ] = ACCEPT + LE;
+  fill(INGT, BACKUP + GT);
+  transition[INGT][CC_EQ] = ACCEPT + GE;
+
+  fill(INNUM, BACKUP + NUM);
+  transition[INNUM][CC_DIGIT] = INNUM;
+  fill(INID, BACKUP + ID);
+  transition[INID][CC_LETTER] = INID;
+
+  /* never entered, the scanner stops on accepting */
+  fill(DONE, BACKUP + ERROR);
+}
+
+/* lookup table of reserved words */
+static struct
+    { char* str;
+      TokenType tok;
+    } reservedWords[MAXRESERVED]
+   = {{"if",IF},{"else",ELSE},{"while",WHILE},{"return",RETURN},
+      {"int",INT},{"void",VOID}};
+
+/* KWSIZE is the size of the keyword hash table */
+#define KWSIZE 16
+
+/* keyword hash of a lexeme, from its length and
+   its first and last characters */
+static int kwhash(int mul, int len, int first, int last)
+{ return (first * mul + last + len) & (KWSIZE - 1);
+}
+
+/* find a multiplier for which kwhash is perfect
+   over the reserved words */
+static int findKeywordHash(int slot[KWSIZE])
+{ int mul, i, h;
+  for (mul = 1; mul < 256; mul++)
+  { for (h = 0; h < KWSIZE; h++) slot[h] = -1;
+    for (i = 0; i < MAXRESERVED; i++)
+    { const char * s = reservedWords[i].str;
+      int len = strlen(s);
+      h = kwhash(mul, len, s[0], s[len-1]);
+      if (slot[h] >= 0) break;
+      slot[h] = i;
+    }
+    if (i == MAXRESERVED) return mul;
+  }
+  return -1;
+}
+
+int main(void)
+{ int slot[KWSIZE];
+  int s, c, h, mul;
+  buildClasses();
+  buildTransitions();
+  mul = findKeywordHash(slot);
+  if (mul < 0)
+  { fprintf(stderr,"scangen: no perfect keyword hash\n");
+    return 1;
+  }
+
+  printf("/* File: scantab.h, generated by scangen; do not edit */\n\n");
+  printf("typedef enum\n   {");
+  for (s = 0; s < NSTATES; s++)
+    printf("%s%s", s ? "," : " ", stateNames[s]);
+  printf(" }\n   StateType;\n\n");
+
+  printf("typedef enum\n   {");
+  for (c = 0; c < NCLASSES; c++)
+    printf("%s%s%s", c ? "," : " ", c && c % 6 == 0 ? "\n    " : "", classNames[c]);
+  printf(" }\n   CharClass;\n\n");
+
+  printf("#define NCLASSES %d\n", NCLASSES);
+  printf("#define ACCEPT %d\n#define BACKUP %d\n\n", ACCEPT, BACKUP);
+
+  printf("static const unsigned char charClass[256] =\n   {");
+  for (c = 0; c < 256; c++)
+    printf("%s%s%d", c ? "," : " ", c && c % 16 == 0 ? "\n    " : "", charClass[c]);
+  printf(" };\n\n");
+
+  printf("static const unsigned char transition[%d][NCLASSES] =\n   {", NSTATES);
+  for (s = 0; s < NSTATES; s++)
+  { printf("%s\n     /* %s */ {", s ? "," : "", stateNames[s]);
+    for (c = 0; c < NCLASSES; c++)
+      printf("%s%d", c ? "," : "", transition[s][c]);
+    printf("}");
+  }
+  printf(" };\n\n");
+
+  printf("#define KWSIZE %d\n", KWSIZE);
+  printf("#define KWHASH(len,first,last) (((first) * %d + (last) + (len)) & (KWSIZE - 1))\n\n", mul);
+  printf("static const struct\n    { const char * str;\n      int len;\n      TokenType tok;\n    } keywordTable[KWSIZE] =\n   {");
+  for (h = 0; h < KWSIZE; h++)
+  { printf("%s", h == 0 ? " " : h % 4 ? "," : ",\n     ");
+    if (slot[h] >= 0)
+      printf("{\"%s\",%d,%s}", reservedWords[slot[h]].str,
+             (int) strlen(reservedWords[slot[h]].str),
+             tokenNames[reservedWords[slot[h]].tok]);
+    else
+      printf("{\"\",0,ID}");
+  }
+  printf(" };\n");
+  return 0;
+}
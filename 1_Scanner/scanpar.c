@@ -0,0 +1,321 @@
+/****************************************************/
+/* File: scanpar.c                                  */
+/* Parallel scanning of one large C- source file    */
+/* The source is cut into chunks right after blanks,*/
+/* where the scanner is either between tokens or    */
+/* inside a comment. Each chunk is scanned for both */
+/* cases at once; the cases are then chained from   */
+/* the first chunk on. Tokens only carry offsets,   */
+/* so no line numbers need to be moved              */
+/****************************************************/
+
+#include <pthread.h>
+#include "globals.h"
+#include "util.h"
+#include "scan.h"
+#include "skip.h"
+
+#ifndef MINCHUNK
+/* MINCHUNK is the smallest chunk worth a thread */
+#define MINCHUNK (1 << 20)
+#endif
+
+/* Chunk is one byte range of the source with the
+ * tokens of both cases
+ */
+typedef struct
+   { int from, to; /* byte range of the chunk */
+     TokenStream plain; /* tokens when starting between tokens */
+     int plainInComment; /* plain case ends inside a comment */
+     TokenStream comment; /* tokens when starting inside a comment */
+     int commentInComment; /* comment case ends inside a comment */
+     int join; /* first plain token that follows the comment
+                  case, -1 if the cases never meet */
+     int failed; /* out of memory */
+     /* set when the cases are chained */
+     int inComment; /* the chunk starts inside a comment */
+     int first; /* index of its first token in the result */
+   } Chunk;
+
+/* ParScan is shared by the threads of one scan */
+typedef struct
+   { SourceMap * source;
+     Chunk * chunks;
+     int nchunks;
+     int next; /* next chunk to hand to a thread */
+     TokenStream * result;
+   } ParScan;
+
+/* growStream resizes the token stream to hold cap tokens */
+static int growStream(TokenStream * ts, int cap)
+{ TokenType * kind = realloc(ts->kind, cap * sizeof(TokenType));
+  int * offset = realloc(ts->offset, cap * sizeof(int));
+  int * length = realloc(ts->length, cap * sizeof(int));
+  if (kind) ts->kind = kind;
+  if (offset) ts->offset = offset;
+  if (length) ts->length = length;
+  if (!kind || !offset || !length)
+    return FALSE;
+  ts->capacity = cap;
+  return TRUE;
+}
+
+/* appendToken adds the last token of s to ts */
+static int appendToken(TokenStream * ts, TokenType kind, Scanner * s)
+{ /* start from about one token per eight bytes of text */
+  if (ts->count == ts->capacity &&
+      !growStream(ts, ts->capacity ? ts->capacity * 2
+                                   : (s->limit - s->pos) / 8 + 16))
+    return FALSE;
+  ts->kind[ts->count] = kind;
+  ts->offset[ts->count] = s->lexeme.offset;
+  ts->length[ts->count] = s->lexeme.length;
+  ts->count++;
+  return TRUE;
+}
+
+/* findOffset returns the token of ts starting at
+   offset, or -1; offsets are increasing */
+static int findOffset(TokenStream * ts, int offset)
+{ int lo = 0, hi = ts->count - 1;
+  while (lo <= hi)
+  { int mid = (lo + hi) / 2;
+    if (ts->offset[mid] < offset) lo = mid + 1;
+    else if (ts->offset[mid] > offset) hi = mid - 1;
+    else return mid;
+  }
+  return -1;
+}
+
+/* scanCase scans the chunk c from pos into ts,
+ * starting between tokens. The final ENDFILE is kept
+ * only for the last chunk. When plain is given, the
+ * scan stops at the first token that plain also
+ * found: both scans are then between tokens at the
+ * same place and agree from there on, and *join is
+ * set to that token. Returns whether the scan ended
+ * inside a comment, or -1 if out of memory.
+ */
+static int scanCase(SourceMap * src, Chunk * c, int pos,
+                    TokenStream * ts, TokenStream * plain, int * join)
+{ Scanner * s = newScanner(src, NULL);
+  TokenType token;
+  int inComment;
+  if (s == NULL)
+    return -1;
+  s->echo = FALSE;
+  s->trace = FALSE;
+  s->pos = pos;
+  s->limit = c->to;
+  while (TRUE)
+  { token = scanToken(s);
+    if (token == ENDFILE && c->to < src->size)
+      break;
+    if (plain != NULL && token != ENDFILE &&
+        (*join = findOffset(plain, s->lexeme.offset)) >= 0)
+      break;
+    if (!appendToken(ts, token, s))
+    { freeScanner(s);
+      return -1;
+    }
+    if (token == ENDFILE)
+      break;
+  }
+  inComment = s->inComment;
+  freeScanner(s);
+  return inComment;
+}
+
+/* scanChunk scans one chunk for both cases */
+static void scanChunk(SourceMap * src, Chunk * c, int isFirst)
+{ const char * p;
+  c->plainInComment = scanCase(src, c, c->from, &c->plain, NULL, NULL);
+  if (c->plainInComment < 0)
+  { c->failed = TRUE;
+    return;
+  }
+  if (isFirst)
+    return;
+  p = skipComment(src->text + c->from, src->text + c->to);
+  /* a comment left open leaves only the ENDFILE
+     of the last chunk */
+  c->commentInComment = scanCase(src, c, p ? p - src->text : c->to,
+                                 &c->comment, &c->plain, &c->join);
+  if (c->commentInComment < 0)
+    c->failed = TRUE;
+  else if (p == NULL)
+    c->commentInComment = TRUE;
+}
+
+/* scanWorker scans chunks until none are left */
+static void * scanWorker(void * arg)
+{ ParScan * ps = (ParScan *) arg;
+  int i;
+  while ((i = __sync_fetch_and_add(&ps->next,1)) < ps->nchunks)
+    scanChunk(ps->source, &ps->chunks[i], i == 0);
+  return NULL;
+}
+
+/* copyTokens copies count tokens of ts from first
+   to the result at index to */
+static void copyTokens(TokenStream * result, int to, TokenStream * ts,
+                       int first, int count)
+{ if (count == 0)
+    return;
+  memcpy(result->kind + to, ts->kind + first, count * sizeof(TokenType));
+  memcpy(result->offset + to, ts->offset + first, count * sizeof(int));
+  memcpy(result->length + to, ts->length + first, count * sizeof(int));
+}
+
+/* copyChunk copies the chosen case of a chunk */
+static void copyChunk(TokenStream * result, Chunk * c)
+{ int to = c->first;
+  int first = 0;
+  if (c->inComment)
+  { copyTokens(result, to, &c->comment, 0, c->comment.count);
+    to += c->comment.count;
+    first = c->join;
+  }
+  if (first >= 0)
+    copyTokens(result, to, &c->plain, first,
+               c->plain.count - first);
+}
+
+/* freeChunk releases the tokens of a chunk */
+static void freeChunk(Chunk * c)
+{ free(c->plain.kind);
+  free(c->plain.offset);
+  free(c->plain.length);
+  free(c->comment.kind);
+  free(c->comment.offset);
+  free(c->comment.length);
+}
+
+/* copyWorker copies each chunk into the result,
+   if there is one, and releases it */
+static void * copyWorker(void * arg)
+{ ParScan * ps = (ParScan *) arg;
+  int i;
+  while ((i = __sync_fetch_and_add(&ps->next,1)) < ps->nchunks)
+  { if (ps->result != NULL)
+      copyChunk(ps->result, &ps->chunks[i]);
+    freeChunk(&ps->chunks[i]);
+  }
+  return NULL;
+}
+
+/* runThreads runs fn on nthreads threads over ps */
+static void runThreads(ParScan * ps, void * (*fn)(void *), int nthreads)
+{ pthread_t * threads = malloc(nthreads * sizeof(pthread_t));
+  int i, started = 0;
+  ps->next = 0;
+  for (i = 0; threads != NULL && i < nthreads; i++)
+    if (pthread_create(&threads[started],NULL,fn,ps) == 0)
+      started++;
+  /* without any thread, work here */
+  if (started == 0)
+    fn(ps);
+  for (i = 0; i < started; i++)
+    pthread_join(threads[i],NULL);
+  free(threads);
+}
+
+/* cutChunks splits the source into at most n chunks,
+   each ending right after a blank; returns the count */
+static int cutChunks(SourceMap * src, Chunk * chunks, int n)
+{ int k, count = 0, from = 0;
+  for (k = 1; k <= n; k++)
+  { int to = k == n ? src->size : (int) ((long) src->size * k / n);
+    if (to < from) to = from;
+    while (to < src->size && src->text[to] != ' ' &&
+           src->text[to] != '\t' && src->text[to] != '\n')
+      to++;
+    if (to < src->size) to++;
+    if (to == from && k < n) continue;
+    memset(&chunks[count], 0, sizeof(Chunk));
+    chunks[count].from = from;
+    chunks[count].to = to;
+    chunks[count].join = -1;
+    count++;
+    from = to;
+    if (to == src->size) break;
+  }
+  return count;
+}
+
+/* Function scanParallel scans src in chunks */
+TokenStream * scanParallel(SourceMap * src, int nthreads)
+{ ParScan ps;
+  TokenStream * ts = (TokenStream *) calloc(1, sizeof(TokenStream));
+  int n = canScanChunks ? src->size / MINCHUNK : 1;
+  int i, total = 0, inComment = FALSE, failed = FALSE;
+  if (n > nthreads) n = nthreads;
+  if (n < 1) n = 1;
+  ps.source = src;
+  ps.chunks = (Chunk *) malloc(n * sizeof(Chunk));
+  if (ts == NULL || ps.chunks == NULL)
+  { free(ts);
+    free(ps.chunks);
+    return NULL;
+  }
+  ps.nchunks = cutChunks(src, ps.chunks, n);
+  ps.result = ts;
+  runThreads(&ps, scanWorker, ps.nchunks);
+
+  /* chain the cases: each chunk starts in the
+     state the chunk before it ended in */
+  for (i = 0; i < ps.nchunks; i++)
+  { Chunk * c = &ps.chunks[i];
+    failed |= c->failed;
+    c->inComment = inComment;
+    c->first = total;
+    if (!inComment)
+    { total += c->plain.count;
+      inComment = c->plainInComment;
+    }
+    else if (c->join >= 0)
+    { total += c->comment.count + c->plain.count - c->join;
+      inComment = c->plainInComment;
+    }
+    else
+    { total += c->comment.count;
+      inComment = c->commentInComment;
+    }
+  }
+  /* a single chunk already is the result */
+  if (ps.nchunks == 1 && !failed)
+  { *ts = ps.chunks[0].plain;
+    free(ps.chunks);
+    return ts;
+  }
+  if (failed || !growStream(ts, total))
+    ps.result = NULL;
+  ts->count = total;
+  runThreads(&ps, copyWorker, ps.nchunks);
+  free(ps.chunks);
+  if (ps.result == NULL)
+  { freeTokenStream(ts);
+    return NULL;
+  }
+  return ts;
+}
+
+/* Procedure listTokens prints the listing of s */
+void listTokens(Scanner * s, TokenStream * ts)
+{ int i;
+  for (i = 0; i < ts->count; i++)
+  { s->lexeme.offset = ts->offset[i];
+    s->lexeme.length = ts->length[i];
+    listToken(s,ts->kind[i]);
+  }
+}
+
+/* Procedure freeTokenStream releases a token stream */
+void freeTokenStream(TokenStream * ts)
+{ if (ts == NULL)
+    return;
+  free(ts->kind);
+  free(ts->offset);
+  free(ts->length);
+  free(ts);
+}
@@ -0,0 +1,169 @@
+/****************************************************/
+/* File: skip.c                                     */
+/* Vectorized skipping of blanks and comments, and  */
+/* the newline scan behind the line index           */
+/* SSE2 handles 16 and AVX2 32 bytes per step, the  */
+/* AVX2 path is chosen at run time; other machines  */
+/* and the last bytes of the source use the scalar  */
+/* loops                                            */
+/****************************************************/
+
+#include "skip.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SKIP_SIMD 1
+#include <immintrin.h>
+#else
+#define SKIP_SIMD 0
+#endif
+
+static const char * skipBlanksScalar(const char * p, const char * end)
+{ while (p < end && (*p == ' ' || *p == '\t' || *p == '\n'))
+    p++;
+  return p;
+}
+
+static const char * skipCommentScalar(const char * p, const char * end)
+{ for (; p < end; p++)
+    if (*p == '*' && p+1 < end && p[1] == '/') return p+2;
+  return NULL;
+}
+
+/* record the line starts after the newlines in mask,
+   a bit set for each newline in the block at p */
+#define RECORD(mask) \
+  do { if (starts == NULL) n += __builtin_popcount(mask); \
+       else for (; mask; mask &= mask - 1) \
+         starts[n++] = p - begin + __builtin_ctz(mask) + 1; } while (0)
+
+static int lineStartsScalar(const char * begin, const char * p,
+                            const char * end, int n, int * starts)
+{ for (; p < end; p++)
+    if (*p == '\n')
+    { if (starts != NULL) starts[n] = p - begin + 1;
+      n++;
+    }
+  return n;
+}
+
+#if SKIP_SIMD
+
+static const char * skipBlanksSSE2(const char * p, const char * end)
+{ const __m128i sp = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i nl = _mm_set1_epi8('\n');
+  for (; p + 16 <= end; p += 16)
+  { __m128i v = _mm_loadu_si128((const __m128i *) p);
+    unsigned blank = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, nl),
+                       _mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, tab))));
+    if (blank != 0xFFFF)
+      return p + __builtin_ctz(~blank);
+  }
+  return skipBlanksScalar(p, end);
+}
+
+static const char * skipCommentSSE2(const char * p, const char * end)
+{ const __m128i star = _mm_set1_epi8('*');
+  for (; p + 16 <= end; p += 16)
+  { __m128i v = _mm_loadu_si128((const __m128i *) p);
+    unsigned stars = _mm_movemask_epi8(_mm_cmpeq_epi8(v, star));
+    /* p[i+1] is at worst the padding after the source */
+    for (; stars; stars &= stars - 1)
+    { int i = __builtin_ctz(stars);
+      if (p[i+1] == '/')
+        return p + i + 2;
+    }
+  }
+  return skipCommentScalar(p, end);
+}
+
+static int lineStartsSSE2(const char * begin, const char * p,
+                          const char * end, int n, int * starts)
+{ const __m128i nl = _mm_set1_epi8('\n');
+  for (; p + 16 <= end; p += 16)
+  { __m128i v = _mm_loadu_si128((const __m128i *) p);
+    unsigned newline = _mm_movemask_epi8(_mm_cmpeq_epi8(v, nl));
+    RECORD(newline);
+  }
+  return lineStartsScalar(begin, p, end, n, starts);
+}
+
+__attribute__((target("avx2")))
+static const char * skipBlanksAVX2(const char * p, const char * end)
+{ const __m256i sp = _mm256_set1_epi8(' ');
+  const __m256i tab = _mm256_set1_epi8('\t');
+  const __m256i nl = _mm256_set1_epi8('\n');
+  for (; p + 32 <= end; p += 32)
+  { __m256i v = _mm256_loadu_si256((const __m256i *) p);
+    unsigned blank = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, nl),
+                       _mm256_or_si256(_mm256_cmpeq_epi8(v, sp), _mm256_cmpeq_epi8(v, tab))));
+    if (blank != 0xFFFFFFFFu)
+      return p + __builtin_ctz(~blank);
+  }
+  return skipBlanksSSE2(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char * skipCommentAVX2(const char * p, const char * end)
+{ const __m256i star = _mm256_set1_epi8('*');
+  for (; p + 32 <= end; p += 32)
+  { __m256i v = _mm256_loadu_si256((const __m256i *) p);
+    unsigned stars = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, star));
+    for (; stars; stars &= stars - 1)
+    { int i = __builtin_ctz(stars);
+      if (p[i+1] == '/')
+        return p + i + 2;
+    }
+  }
+  return skipCommentSSE2(p, end);
+}
+
+__attribute__((target("avx2")))
+static int lineStartsAVX2(const char * begin, const char * p,
+                          const char * end, int n, int * starts)
+{ const __m256i nl = _mm256_set1_epi8('\n');
+  for (; p + 32 <= end; p += 32)
+  { __m256i v = _mm256_loadu_si256((const __m256i *) p);
+    unsigned newline = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nl));
+    RECORD(newline);
+  }
+  return lineStartsSSE2(begin, p, end, n, starts);
+}
+
+#endif
+
+/* Function skipBlanks skips spaces, tabs and newlines */
+const char * skipBlanks(const char * p, const char * end)
+{
+#if SKIP_SIMD
+  if (__builtin_cpu_supports("avx2"))
+    return skipBlanksAVX2(p, end);
+  return skipBlanksSSE2(p, end);
+#else
+  return skipBlanksScalar(p, end);
+#endif
+}
+
+/* Function skipComment skips to the end of a comment */
+const char * skipComment(const char * p, const char * end)
+{
+#if SKIP_SIMD
+  if (__builtin_cpu_supports("avx2"))
+    return skipCommentAVX2(p, end);
+  return skipCommentSSE2(p, end);
+#else
+  return skipCommentScalar(p, end);
+#endif
+}
+
+/* Function lineStarts counts or records newlines */
+int lineStarts(const char * p, const char * end, int * starts)
+{
+#if SKIP_SIMD
+  if (__builtin_cpu_supports("avx2"))
+    return lineStartsAVX2(p, p, end, 0, starts);
+  return lineStartsSSE2(p, p, end, 0, starts);
+#else
+  return lineStartsScalar(p, p, end, 0, starts);
+#endif
+}
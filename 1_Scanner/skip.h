@@ -0,0 +1,28 @@
+/****************************************************/
+/* File: skip.h                                     */
+/* Vectorized skipping of blanks and comments       */
+/****************************************************/
+
+#ifndef _SKIP_H_
+#define _SKIP_H_
+
+/* Function skipBlanks returns the first character
+ * in [p, end) that is not a space, tab or newline,
+ * or end
+ */
+const char * skipBlanks(const char * p, const char * end);
+
+/* Function skipComment returns the character after
+ * the first closing star-slash in [p, end), with p
+ * just inside the comment, or NULL if the comment is
+ * not closed
+ */
+const char * skipComment(const char * p, const char * end);
+
+/* Function lineStarts returns the number of newlines
+ * in [p, end); unless starts is NULL, the offset from
+ * p of the character after each one is stored there
+ */
+int lineStarts(const char * p, const char * end, int * starts);
+
+#endif
@@ -0,0 +1,173 @@
+/****************************************************/
+/* File: srcmap.c                                   */
+/* Memory-mapped source text for the C- scanner     */
+/****************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "srcmap.h"
+#include "skip.h"
+
+/* PADDING is the number of NUL bytes after the text */
+#define PADDING 2
+
+/* map the file privately, so that scanners may write
+   into the text (flex temporarily stores a NUL after
+   each token) without touching the file itself */
+static char * map_file(int fd, size_t size, size_t * mapped)
+{ long page = sysconf(_SC_PAGESIZE);
+  size_t len = (size + PADDING + page - 1) / page * page;
+  char * base;
+  /* reserve zero-filled pages first, so that padding
+     still exists when the size is a multiple of the
+     page size, then place the file on top of them */
+  base = mmap(NULL, len, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED)
+    return NULL;
+  if (mmap(base, size, PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+  { munmap(base, len);
+    return NULL;
+  }
+  madvise(base, len, MADV_SEQUENTIAL);
+  *mapped = len;
+  return base;
+}
+
+/* read the whole file into the heap */
+static char * read_file(int fd, size_t * size)
+{ size_t cap = 4096, len = 0;
+  char * buf = malloc(cap);
+  ssize_t n;
+  while (buf != NULL)
+  { if (cap - len < PADDING + 1)
+    { char * grown = realloc(buf, cap * 2);
+      if (grown == NULL)
+        break;
+      buf = grown;
+      cap *= 2;
+    }
+    n = read(fd, buf + len, cap - len - PADDING);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0)
+      break;
+    if (n == 0)
+    { memset(buf + len, 0, PADDING);
+      *size = len;
+      return buf;
+    }
+    len += n;
+  }
+  free(buf);
+  return NULL;
+}
+
+/* Function srcmap_open maps the given file into memory */
+SourceMap * srcmap_open(const char * path)
+{ struct stat st;
+  SourceMap * map;
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+  map = (SourceMap *) malloc(sizeof(SourceMap));
+  if (map == NULL)
+  { close(fd);
+    return NULL;
+  }
+  map->text = NULL;
+  map->size = 0;
+  map->mapped = 0;
+  map->lineStart = NULL;
+  map->nlines = 0;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+  { map->size = st.st_size;
+    map->text = map_file(fd, map->size, &map->mapped);
+  }
+  if (map->text == NULL)
+    map->text = read_file(fd, &map->size);
+  close(fd);
+  /* token offsets are ints */
+  if (map->text != NULL && map->size > INT_MAX)
+  { srcmap_close(map);
+    errno = EFBIG;
+    return NULL;
+  }
+  if (map->text == NULL)
+  { free(map);
+    return NULL;
+  }
+  return map;
+}
+
+/* Function srcmap_text copies a lexeme into buf */
+char * srcmap_text(const SourceMap * map, TokenSlice slice, char * buf, int size)
+{ int n = slice.length < size ? slice.length : size-1;
+  memcpy(buf, map->text + slice.offset, n);
+  buf[n] = '\0';
+  return buf;
+}
+
+/* Function srcmap_lines builds the line index: one
+   vectorized pass counts the newlines to size the
+   table, a second one records where the lines start */
+int srcmap_lines(SourceMap * map)
+{ const char * end = map->text + map->size;
+  int n;
+  if (map->lineStart != NULL)
+    return map->nlines;
+  n = lineStarts(map->text, end, NULL);
+  map->lineStart = (int *) malloc((n + 1) * sizeof(int));
+  if (map->lineStart == NULL)
+    return -1;
+  map->lineStart[0] = 0;
+  lineStarts(map->text, end, map->lineStart + 1);
+  map->nlines = n + 1;
+  return map->nlines;
+}
+
+/* Function srcmap_line returns the line at offset */
+int srcmap_line(SourceMap * map, int offset)
+{ int lo = 0, hi;
+  /* without memory for the index, count the newlines */
+  if (srcmap_lines(map) < 0)
+    return lineStarts(map->text, map->text + offset, NULL) + 1;
+  /* the last line starting at or before offset */
+  hi = map->nlines - 1;
+  while (lo < hi)
+  { int mid = (lo + hi + 1) / 2;
+    if (map->lineStart[mid] <= offset) lo = mid;
+    else hi = mid - 1;
+  }
+  return lo + 1;
+}
+
+/* Function srcmap_column returns the column at offset */
+int srcmap_column(SourceMap * map, int offset)
+{ int line = srcmap_line(map, offset);
+  const char * p;
+  if (map->lineStart != NULL)
+    return offset - map->lineStart[line-1] + 1;
+  for (p = map->text + offset; p > map->text && p[-1] != '\n'; p--)
+    ;
+  return map->text + offset - p + 1;
+}
+
+/* Procedure srcmap_close releases the source map */
+void srcmap_close(SourceMap * map)
+{ if (map == NULL)
+    return;
+  if (map->mapped)
+    munmap(map->text, map->mapped);
+  else
+    free(map->text);
+  free(map->lineStart);
+  free(map);
+}
@@ -0,0 +1,68 @@
+/****************************************************/
+/* File: srcmap.h                                   */
+/* Memory-mapped source text for the C- scanner     */
+/****************************************************/
+
+#ifndef _SRCMAP_H_
+#define _SRCMAP_H_
+
+#include <stddef.h>
+
+/* SourceMap holds the whole source program in memory.
+ * The text is followed by two NUL bytes, so scanners
+ * may read one character past the end without a bound
+ * check (flex's yy_scan_buffer requires the same).
+ */
+typedef struct
+   { char * text; /* first byte of the source */
+     size_t size; /* length of the text, excluding padding */
+     size_t mapped; /* length of the mapping, 0 if read into the heap */
+     int * lineStart; /* offset of the start of each line, NULL until
+                         a line number is first asked for */
+     int nlines; /* entries of lineStart */
+   } SourceMap;
+
+/* TokenSlice locates a lexeme as a byte range
+ * of the source map, so that scanning never
+ * has to copy the token text
+ */
+typedef struct
+   { int offset;
+     int length;
+   } TokenSlice;
+
+/* Function srcmap_open maps the given file into
+ * memory, falling back to reading it into the heap
+ * when the file cannot be mapped (pipes, empty files).
+ * Returns NULL if the file cannot be read.
+ */
+SourceMap * srcmap_open(const char * path);
+
+/* Function srcmap_text copies a lexeme of the map
+ * into buf, truncated to size-1 characters, and
+ * returns buf
+ */
+char * srcmap_text(const SourceMap *, TokenSlice, char * buf, int size);
+
+/* Function srcmap_line returns the line number of
+ * the character at offset, counting from 1. The line
+ * index is built on the first call, so a map shared
+ * by threads should have it built by srcmap_lines
+ * beforehand.
+ */
+int srcmap_line(SourceMap *, int offset);
+
+/* Function srcmap_column returns the column of the
+ * character at offset, counting bytes from 1
+ */
+int srcmap_column(SourceMap *, int offset);
+
+/* Function srcmap_lines builds the line index and
+ * returns the number of lines, or -1 if out of memory
+ */
+int srcmap_lines(SourceMap *);
+
+/* Procedure srcmap_close releases the source map */
+void srcmap_close(SourceMap *);
+
+#endif
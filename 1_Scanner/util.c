@@ -9,10 +9,10 @@
 #include "globals.h"
 #include "util.h"
 
-/* Procedure printToken prints a token 
- * and its lexeme to the listing file
+/* Procedure fprintToken prints a token 
+ * and its lexeme to the file out
  */
-void printToken( TokenType token, const char* tokenString )
+void fprintToken( FILE * out, TokenType token, const char* tokenString )
 { switch (token)
   { case IF:
     case ELSE:
@@ -20,46 +20,53 @@ void printToken( TokenType token, const char* tokenString )
     case RETURN:
     case INT:
     case VOID:
-      fprintf(listing,
+      fprintf(out,
          "reserved word: %s\n",tokenString);
       break;
-    case ASSIGN: fprintf(listing,"=\n"); break;
-    case EQ: fprintf(listing,"==\n"); break;
-    case NE: fprintf(listing,"!=\n"); break;
-    case LT: fprintf(listing,"<\n"); break;
-    case LE: fprintf(listing, "<=\n"); break;
-    case GT: fprintf(listing, ">\n"); break;
-    case GE: fprintf(listing, ">=\n"); break;
-    case LPAREN: fprintf(listing,"(\n"); break;
-    case RPAREN: fprintf(listing,")\n"); break;
-    case LBRACE: fprintf(listing, "[\n"); break;
-    case RBRACE: fprintf(listing, "]\n"); break;
-    case LCURLY: fprintf(listing, "{\n"); break;
-    case RCURLY: fprintf(listing, "}\n"); break;
-    case SEMI: fprintf(listing,";\n"); break;
-    case COMMA: fprintf(listing, ",\n"); break;
-    case PLUS: fprintf(listing,"+\n"); break;
-    case MINUS: fprintf(listing,"-\n"); break;
-    case TIMES: fprintf(listing,"*\n"); break;
-    case OVER: fprintf(listing,"/\n"); break;
-    case ENDFILE: fprintf(listing,"EOF\n"); break;
+    case ASSIGN: fprintf(out,"=\n"); break;
+    case EQ: fprintf(out,"==\n"); break;
+    case NE: fprintf(out,"!=\n"); break;
+    case LT: fprintf(out,"<\n"); break;
+    case LE: fprintf(out, "<=\n"); break;
+    case GT: fprintf(out, ">\n"); break;
+    case GE: fprintf(out, ">=\n"); break;
+    case LPAREN: fprintf(out,"(\n"); break;
+    case RPAREN: fprintf(out,")\n"); break;
+    case LBRACE: fprintf(out, "[\n"); break;
+    case RBRACE: fprintf(out, "]\n"); break;
+    case LCURLY: fprintf(out, "{\n"); break;
+    case RCURLY: fprintf(out, "}\n"); break;
+    case SEMI: fprintf(out,";\n"); break;
+    case COMMA: fprintf(out, ",\n"); break;
+    case PLUS: fprintf(out,"+\n"); break;
+    case MINUS: fprintf(out,"-\n"); break;
+    case TIMES: fprintf(out,"*\n"); break;
+    case OVER: fprintf(out,"/\n"); break;
+    case ENDFILE: fprintf(out,"EOF\n"); break;
     case NUM:
-      fprintf(listing,
+      fprintf(out,
           "NUM, val= %s\n",tokenString);
       break;
     case ID:
-      fprintf(listing,
+      fprintf(out,
           "ID, name= %s\n",tokenString);
       break;
     case ERROR:
-      fprintf(listing,
+      fprintf(out,
           "ERROR: %s\n",tokenString);
       break;
     default: /* should never happen */
-      fprintf(listing,"Unknown token: %d\n",token);
+      fprintf(out,"Unknown token: %d\n",token);
   }
 }
 
+/* Procedure printToken prints a token 
+ * and its lexeme to the listing file
+ */
+void printToken( TokenType token, const char* tokenString )
+{ fprintToken(listing,token,tokenString);
+}
+
 /* Function newStmtNode creates a new statement
  * node for syntax tree construction
  */
@@ -112,6 +119,13 @@ char * copyString(char * s)
   return t;
 }
 
+/* Function sliceText copies a lexeme into buf,
+ * truncated to size-1 characters, and returns buf
+ */
+char * sliceText(TokenSlice slice, char * buf, int size)
+{ return srcmap_text(source,slice,buf,size);
+}
+
 /* Variable indentno is used by printTree to
  * store current number of spaces to indent
  */
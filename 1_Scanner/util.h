@@ -8,6 +8,11 @@
 #ifndef _UTIL_H_
 #define _UTIL_H_
 
+/* Procedure fprintToken prints a token 
+ * and its lexeme to the file out
+ */
+void fprintToken( FILE *, TokenType, const char* );
+
 /* Procedure printToken prints a token 
  * and its lexeme to the listing file
  */
@@ -28,6 +33,11 @@ TreeNode * newExpNode(ExpKind);
  */
 char * copyString( char * );
 
+/* Function sliceText copies a lexeme into buf,
+ * truncated to size-1 characters, and returns buf
+ */
+char * sliceText( TokenSlice, char *, int );
+
 /* procedure printTree prints a syntax tree to the 
  * listing file using indentation to indicate subtrees
  */
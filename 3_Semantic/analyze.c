@@ -6,90 +6,176 @@
 /* Kenneth C. Louden                                */
 /****************************************************/
 
+#include <pthread.h>
 #include "globals.h"
 #include "symtab.h"
 #include "analyze.h"
 #include "util.h"
 
-/* Procedure traverse is a generic recursive 
- * syntax tree traversal routine:
+/* Procedure traverse is a generic syntax tree
+ * traversal routine:
  * it applies preProc in preorder and postProc 
- * in postorder to tree pointed to by t
+ * in postorder to tree pointed to by t.
+ * The path to the current node is kept on a
+ * TreeStack; a sibling takes the frame of the node
+ * before it, so long lists do not deepen the stack.
  */
-static void traverse( TreeNode * t,
-               void (* preProc) (TreeNode *),
-               void (* postProc) (TreeNode *) )
-{ if (t != NULL)
-  { preProc(t);
-    { int i;
-      for (i=0; i < MAXCHILDREN; i++)
-        traverse(t->child[i],preProc,postProc);
+static void traverse( TreeNode t,
+               void (* preProc) (TreeNode),
+               void (* postProc) (TreeNode) )
+{ TreeStack stack = { NULL, -1, 0 };
+  if (t != NULLNODE && pushFrame(&stack,t))
+    preProc(t);
+  while (stack.top >= 0)
+  { TreeFrame * f = &stack.frames[stack.top];
+    if (f->child < MAXCHILDREN)
+    { TreeNode c = CHILD(f->node,f->child++);
+      if (c == NULLNODE)
+        continue;
+      if (!pushFrame(&stack,c))
+        break;
+      preProc(c);
+    }
+    else
+    { postProc(f->node);
+      if ((f->node = SIBLING(f->node)) != NULLNODE)
+      { f->child = 0;
+        preProc(f->node);
+      }
+      else
+        stack.top--;
     }
-    postProc(t);
-    traverse(t->sibling,preProc,postProc);
   }
+  free(stack.frames);
 }
 
 /* nullProc is a do-nothing procedure to 
  * generate preorder-only or postorder-only
  * traversals from traverse
  */
-static void nullProc(TreeNode * t)
-{ if (t==NULL) return;
+static void nullProc(TreeNode t)
+{ if (t==NULLNODE) return;
   else return;
 }
 
-/* Scope block. */
+/* Scope block. A block gets its scope record only
+ * when it, or a block in it, declares something.
+ */
 typedef struct {
   int location;
-  char * name;
+  ScopeList scope; // NULL until a declaration needs it
+  ScopeList inner; // scope, or that of the nearest enclosing block
+  int lineno, num; // names the block, see symtab.h
 } ScopeBlock;
 
-/* Scope stack. */
-#define SCOPE_MAX 100
-static ScopeBlock scope[SCOPE_MAX];
-static int scopeidx;
+/* Scope stack, grown as scopes nest. */
+static __thread ScopeBlock * scope;
+static __thread int scopeidx;
+static __thread int scopecap;
+/* Scopes not pushed for lack of memory */
+static __thread int scopelost;
 /* For empty name compound statement of new scoping */
-static int fnscope;
+static __thread int fnscope;
 /* For annonymous scope */
-static int annon_lineno;
-static int annon_num;
+static __thread int annon_lineno;
+static __thread int annon_num;
+
+/* Push a block on the scope stack as the current
+ * scope, with record s or none; returns FALSE if
+ * out of memory.
+ */
+static int push_scope(ScopeList s)
+{ if (scopeidx + 1 >= scopecap)
+  { int cap = scopecap ? scopecap * 2 : 64;
+    ScopeBlock * blocks = realloc(scope, cap * sizeof(ScopeBlock));
+    if (blocks == NULL)
+    { fprintf(listing,"Out of memory error in scope stack\n");
+      Error = TRUE;
+      scopelost += 1;
+      return FALSE;
+    }
+    scope = blocks;
+    scopecap = cap;
+  }
+  scopeidx += 1;
+  scope[scopeidx].scope = s;
+  scope[scopeidx].inner = s != NULL ? s : scope[scopeidx-1].inner;
+  scope[scopeidx].location = 0;
+  return TRUE;
+}
+
+/* Enter the scope of a function. */
+static void enter_scope(ScopeList s)
+{ push_scope(s);
+}
+
+/* Enter an anonymous block at lineno, numbering it
+ * after the blocks before it on the same line.
+ */
+static void enter_block(int lineno)
+{ if (annon_lineno != lineno)
+  { annon_lineno = lineno;
+    annon_num = 0;
+  }
+  if (push_scope(NULL))
+  { scope[scopeidx].lineno = annon_lineno;
+    scope[scopeidx].num = annon_num;
+  }
+  annon_num++;
+}
+
+/* Return the record of the current scope, making
+ * those of the current block and of the enclosing
+ * blocks that have none yet, outermost first; NULL
+ * if out of memory.
+ */
+static ScopeList current_scope(void)
+{ ScopeList s;
+  int i = scopeidx;
+  while (scope[i].scope == NULL)
+    i--;
+  for (i++; i <= scopeidx; i++)
+  { s = scope_insert(scope[i-1].scope, NULL);
+    if (s == NULL)
+      return NULL;
+    s->lineno = scope[i].lineno;
+    s->num = scope[i].num;
+    scope[i].scope = scope[i].inner = s;
+  }
+  return scope[scopeidx].scope;
+}
+
+/* Pop the current scope. */
+static void leave_scope(void)
+{ if (scopelost > 0)
+    scopelost -= 1;
+  else
+    scopeidx -= 1;
+}
 
 static void init_scope_info(int startloc)
-{ scopeidx = 0;
+{ scopeidx = -1;
+  scopelost = 0;
   fnscope = 0;
   annon_lineno = 0;
   annon_num = 0;
-  scope[0].name = "global";
+  enter_scope(global_scope());
   scope[0].location = startloc;
 }
 
-static char * annon_scope_name(int lineno)
-{
-#define ANNON_PREFIX "annon_"
-#define ANNON_PREFIX_SIZE 6
-// maximum number of the digits.
-#define ANNON_POSTFIX 10
-  char * name = (char *)malloc(
-    sizeof(char) * (ANNON_PREFIX_SIZE + ANNON_POSTFIX + 1));
-  strcpy(name, ANNON_PREFIX);
-  if (annon_lineno != lineno)
-  { annon_lineno = lineno;
-    annon_num = 0;
-  }
-  snprintf(name + ANNON_PREFIX_SIZE, ANNON_POSTFIX,
-    "%d_%d", annon_lineno, annon_num++);
-  return name;
+static void free_scope_info(void)
+{ free(scope);
+  scope = NULL;
+  scopecap = 0;
 }
 
 /* Post process for insert node. */
-static void postInsert( TreeNode * t )
-{ switch (t->nodekind)
+static void postInsert( TreeNode t )
+{ switch (NODEKIND(t))
   { case StmtK:
-      switch (t->kind.stmt)
+      switch (KIND(t))
       { case CompK:
-          free(scope[scopeidx].name);
-          scopeidx -= 1;
+          leave_scope();
           break;
         default:
           break;
@@ -100,31 +186,81 @@ static void postInsert( TreeNode * t )
   }
 }
 
-static void typeError(TreeNode * t, char * message)
-{ fprintf(listing,"Error: %s at line %d (name : %s)\n",
-    message, t->lineno, t->attr.name);
+/* Error held back by a thread of typeCheckParallel,
+ * or by buildAndCheck. */
+typedef struct {
+  TreeNode t;
+  char * message;
+  int named; // printed with the name of t
+} Diagnostic;
+
+/* While deferring, errors go to diags instead of the
+ * listing, see typeCheckParallel and buildAndCheck;
+ * each thread has its own.
+ */
+static __thread int deferring;
+static __thread Diagnostic * diags;
+static __thread int ndiags;
+static __thread int diagcap;
+/* An error could not be kept for lack of memory */
+static __thread int diagslost;
+
+static void printError(TreeNode t, char * message, int named)
+{ // POS(t) is the lookahead, good for the line only
+  noteError(lineOf(POS(t)), 0, message, named ? ATTR(t).name : NULL);
+  if (named)
+    fprintf(listing,"Error: %s at line %d (name : %s)\n",
+      message, lineOf(POS(t)), ATTR(t).name);
+  else
+    fprintf(listing, "Error: %s at line %d\n", message, lineOf(POS(t)));
   Error = TRUE;
 }
 
-static void simpleError(TreeNode * t, char * message)
-{ fprintf(listing, "Error: %s at line %d\n", message, t->lineno);
-  Error = TRUE;
+static void reportError(TreeNode t, char * message, int named)
+{ if (deferring)
+  { if (ndiags == diagcap)
+    { int cap = diagcap ? diagcap * 2 : 64;
+      Diagnostic * d = realloc(diags, cap * sizeof(Diagnostic));
+      // without room, typeCheckParallel checks the
+      // declaration again and reportChecks gives up
+      if (d == NULL)
+      { diagslost = TRUE;
+        return;
+      }
+      diags = d;
+      diagcap = cap;
+    }
+    diags[ndiags].t = t;
+    diags[ndiags].message = message;
+    diags[ndiags].named = named;
+    ndiags++;
+  }
+  else
+    printError(t, message, named);
+}
+
+static void typeError(TreeNode t, char * message)
+{ reportError(t, message, TRUE);
+}
+
+static void simpleError(TreeNode t, char * message)
+{ reportError(t, message, FALSE);
 }
 
 /* Procedure insertNode inserts 
  * identifiers stored in t into 
  * the symbol table 
  */
-static void insertNode( TreeNode * t)
+static void insertNode( TreeNode t)
 { int size;
-  char * name;
   SymAddr addr;
-  switch (t->nodekind)
+  ScopeList s;
+  switch (NODEKIND(t))
   { case DeclK:
-      addr = st_lookup(scope[scopeidx].name, t->attr.name);
-      switch (t->kind.decl)
+      addr = st_lookup(scope[scopeidx].inner, ATTR(t).name);
+      switch (KIND(t))
       { case ParamK:
-          if (t->type == Void)
+          if (TYPE(t) == Void)
             break;
           // fall through
         case VarK:
@@ -133,17 +269,20 @@ static void insertNode( TreeNode * t)
             break;
           }
           size = -1;
-          if (t->child[0] != NULL)
-          { size = t->child[0]->attr.val;
-            if (t->kind.decl == VarK && size <= 0)
+          if (CHILD(t,0) != NULLNODE)
+          { size = ATTR(CHILD(t,0)).val;
+            if (KIND(t) == VarK && size <= 0)
             { typeError(t, "array size cannot be non-positive");
               break;
             }
           }
-          st_insert(
-            scope_find(scope[scopeidx].name),
-            t->attr.name, t->type, size,
-            t->lineno, scope[scopeidx].location++);
+          if ((s = current_scope()) == NULL || st_insert(
+                s,
+                ATTR(t).name, TYPE(t), size,
+                lineOf(POS(t)), scope[scopeidx].location++) == NULL)
+          { fprintf(listing,"Out of memory error in symbol table\n");
+            Error = TRUE;
+          }
           break;
         case FnK:
           if (addr.bucket != 0)
@@ -151,16 +290,27 @@ static void insertNode( TreeNode * t)
             break;
           }
           // insert function
-          addr.bucket = st_insert(
-            scope_find(scope[scopeidx].name),
-            t->attr.name, Function, -1,
-            t->lineno, scope[scopeidx].location++);
-          st_appendfn(addr.bucket, t);
-          scope_insert(scope[scopeidx].name, t->attr.name);
+          s = current_scope();
+          addr.bucket = s == NULL ? NULL : st_insert(
+            s,
+            ATTR(t).name, Function, -1,
+            lineOf(POS(t)), scope[scopeidx].location++);
+          if (addr.bucket == NULL || !st_appendfn(addr.bucket, t))
+          { fprintf(listing,"Out of memory error in symbol table\n");
+            Error = TRUE;
+            // the body still leaves a scope
+            enter_scope(NULL);
+            fnscope = 1;
+            break;
+          }
+          SYM(t) = addr.bucket;
           // update current scope info
-          scopeidx += 1;
-          scope[scopeidx].name = copyString(t->attr.name);
-          scope[scopeidx].location = 0;
+          s = scope_insert(s, ATTR(t).name);
+          if (s == NULL)
+          { fprintf(listing,"Out of memory error in symbol table\n");
+            Error = TRUE;
+          }
+          enter_scope(s);
           fnscope = 1;
           break;
         default:
@@ -168,19 +318,13 @@ static void insertNode( TreeNode * t)
       }
       break;
     case StmtK:
-      switch (t->kind.stmt)
+      switch (KIND(t))
       { case CompK:
           if (fnscope)
             fnscope = 0;
           else
-          { // generate annonymous scope with normalized postfix
-            name = annon_scope_name(t->lineno);
-            // generate new scope
-            scope_insert(scope[scopeidx].name, name);
-            // update current scope
-            scopeidx += 1;
-            scope[scopeidx].name = name;
-            scope[scopeidx].location = 0;
+          { // enter annonymous scope, numbered per line
+            enter_block(lineOf(POS(t)));
           }
           break;
         case IfK:
@@ -191,7 +335,7 @@ static void insertNode( TreeNode * t)
       }
       break;
     case ExpK:
-      switch (t->kind.exp)
+      switch (KIND(t))
       { case AssignK:
         case OpK:
         case ConstK:
@@ -199,13 +343,14 @@ static void insertNode( TreeNode * t)
         case IdK:
           // fall through
         case CallK:
-          addr = st_lookup(scope[scopeidx].name, t->attr.name);
+          addr = st_lookup(scope[scopeidx].inner, ATTR(t).name);
+          SYM(t) = addr.bucket;
           if (addr.bucket == 0)
             typeError(t, "undeclared id");
           else
           /* already in table, so ignore location, 
              add line number of use only */ 
-            st_appendline(addr.bucket, t->lineno);
+            st_appendline(addr.bucket, lineOf(POS(t)));
           break;
         case IdxK:
         default:
@@ -217,22 +362,28 @@ static void insertNode( TreeNode * t)
   }
 }
 
-#define INIT_LOC 2  // assume INI_LOC = nextloc
-/* Initialize states in global scope. */
-static void init_state()
+/* Initialize states in global scope, and the
+ * bindings of the tree; returns FALSE if out of memory.
+ */
+static int init_state()
 { // initialize scope
   int nextloc = global_init();
+  free(ast->sym);
+  ast->sym = nextloc < 0 ? NULL :
+    (BucketList *) calloc(ast->count, sizeof(BucketList));
+  if (ast->sym == NULL)
+  { fprintf(listing,"Out of memory error in symbol table\n");
+    Error = TRUE;
+    return FALSE;
+  }
   // initialize scope block
   init_scope_info(nextloc);
+  return TRUE;
 }
 
-/* Function buildSymtab constructs the symbol 
- * table by preorder traversal of the syntax tree
- */
-void buildSymtab(TreeNode * syntaxTree)
-{ init_state();
-  traverse(syntaxTree,insertNode,postInsert);
-  if (Error == 0 && TraceAnalyze)
+/* Print the tables of the symbol table. */
+static void print_tables(void)
+{ if (Error == 0 && TraceAnalyze)
   { fprintf(listing,"\n< Symbol table >\n");
     printSymTab(listing);
     fprintf(listing, "\n< Function Table >\n");
@@ -244,63 +395,48 @@ void buildSymtab(TreeNode * syntaxTree)
   }
 }
 
-static void scopeSetting(TreeNode * t)
-{ char * name;
-  switch (t->nodekind)
-  { case DeclK:
-      switch (t->kind.decl)
-      { case FnK:
-          // update current scope info
-          scopeidx += 1;
-          scope[scopeidx].name = copyString(t->attr.name);
-          scope[scopeidx].location = 0;
-          fnscope = 1;
-          break;
-        default:
-          break;
-      }
-      break;
-    case StmtK:
-      switch (t->kind.stmt)
-      { case CompK:
-          if (fnscope)
-            fnscope = 0;
-          else
-          { // update current scope
-            scopeidx += 1;
-            scope[scopeidx].name = annon_scope_name(t->lineno);;
-            scope[scopeidx].location = 0;
-          }
-          break;
-        default:
-          break;
-      }
-      break;
-    default:
-      break;
-  }
+/* Function buildSymtab constructs the symbol 
+ * table by preorder traversal of the syntax tree,
+ * and binds each identifier and function node to
+ * its symbol for typeCheck
+ */
+void buildSymtab(TreeNode syntaxTree)
+{ if (!init_state())
+    return;
+  traverse(syntaxTree,insertNode,postInsert);
+  free_scope_info();
+  print_tables();
+}
+
+/* Function whose body is being checked, per thread */
+static __thread BucketList fnbucket;
+
+/* Remember the function whose body follows. */
+static void fnSetting(TreeNode t)
+{ if (NODEKIND(t) == DeclK && KIND(t) == FnK)
+    fnbucket = SYM(t);
 }
 
 /* Procedure checkNode performs
  * type checking at a single tree node
  */
-static void checkNode(TreeNode * t)
+static void checkNode(TreeNode t)
 { int i;
-  TreeNode * node;
-  SymAddr addr;
-  switch (t->nodekind)
+  TreeNode node;
+  BucketList sym = SYM(t);
+  switch (NODEKIND(t))
   { case DeclK:
-      switch (t->kind.decl)
+      switch (KIND(t))
       { case ParamK:
           // only single unnamed void parameter is available
-          if (t->type == Void && (
+          if (TYPE(t) == Void && (
             // (null) is predefined empty void parameter name
-              strcmp(t->attr.name, "(null)") || t->sibling != NULL))
+              strcmp(ATTR(t).name, "(null)") || SIBLING(t) != NULLNODE))
             typeError(t, "Variable Type cannot be Void");
           break;
         case VarK:
           // void cannot be variable type
-          if (t->type == Void)
+          if (TYPE(t) == Void)
             typeError(t, "Variable Type cannot be Void");
           break;
         case FnK:
@@ -311,82 +447,88 @@ static void checkNode(TreeNode * t)
       }
       break;
     case ExpK:
-      switch (t->kind.exp)
+      switch (KIND(t))
       {
        case AssignK:
           // only expression to variable is assignable
-          if (t->child[0]->nodekind != ExpK || t->child[0]->kind.exp != IdK
-              || t->child[1]->nodekind != ExpK)
+          if (NODEKIND(CHILD(t,0)) != ExpK || KIND(CHILD(t,0)) != IdK
+              || NODEKIND(CHILD(t,1)) != ExpK)
           { simpleError(t, "invalid expression");
             break;
           }
           // cannot assign to function
-          if (t->child[0]->type == Function)
+          if (TYPE(CHILD(t,0)) == Function)
           { simpleError(t, "cannot assign to function");
             break;
           }
-          if (t->child[0]->type == Array)
+          if (TYPE(CHILD(t,0)) == Array)
           { simpleError(t, "cannot assign to array variable");
             break;
           }
           // only expression of same type is assignable
-          if (t->child[0]->type != t->child[1]->type)
+          if (TYPE(CHILD(t,0)) != TYPE(CHILD(t,1)))
           { simpleError(t, "type miss match");
             break;
           }
           // assign type
-          t->type = t->child[0]->type;
+          TYPE(t) = TYPE(CHILD(t,0));
           break;
         case OpK:
           // currently only integer operation is available
-          if ((t->child[0]->type != Integer) ||
-              (t->child[1]->type != Integer))
+          if ((TYPE(CHILD(t,0)) != Integer) ||
+              (TYPE(CHILD(t,1)) != Integer))
           { simpleError(t,"operation applied to non-integer");
             break;
           }
           // assume all operation results are integer, no boolean
-          t->type = Integer;
+          TYPE(t) = Integer;
           break;
         case ConstK:
           // assume that all constant is integer
-          t->type = Integer;
+          TYPE(t) = Integer;
           break;
         case IdK:
-          addr = st_lookup(scope[scopeidx].name, t->attr.name);
-          if (addr.bucket->size > 0 && t->child[0] == NULL)
+          // undeclared, buildSymtab reported it
+          if (sym == NULL)
+            break;
+          if (sym->size > 0 && CHILD(t,0) == NULLNODE)
             // array declared but do not have indexing child
-            t->type = Array;
+            TYPE(t) = Array;
           else
-            t->type = addr.bucket->type;
+            TYPE(t) = sym->type;
           break;
         case CallK:
-          addr = st_lookup(scope[scopeidx].name, t->attr.name);
+          // only a function can be called
+          if (sym == NULL || sym->fninfo == NULL)
+          { typeError(t, "call of non-function");
+            break;
+          }
           // counting number of the arguments
           i = 0;
-          node = t->child[0];
-          while (node != NULL)
+          node = CHILD(t,0);
+          while (node != NULLNODE)
           { i += 1;
-            node = node->sibling;
+            node = SIBLING(node);
           }
           // check parameter numbers
-          if (i != addr.bucket->fninfo->numparam)
+          if (i != sym->fninfo->numparam)
           { simpleError(t, "the numbers of the parameters are different");
             break;
           }
           // check param type
-          node = t->child[0];
-          for (i = 0; i < addr.bucket->fninfo->numparam; ++i)
-          { if (addr.bucket->fninfo->params[i].type != node->type)
+          node = CHILD(t,0);
+          for (i = 0; i < sym->fninfo->numparam; ++i)
+          { if (sym->fninfo->params[i].type != TYPE(node))
             { simpleError(t, "parameter type mismatch");
               break;
             }
-            node = node->sibling;
+            node = SIBLING(node);
           }
           // assign type
-          t->type = addr.bucket->fninfo->retn;
+          TYPE(t) = sym->fninfo->retn;
           break;
         case IdxK:
-          if (t->child[0]->type != Integer)
+          if (TYPE(CHILD(t,0)) != Integer)
             simpleError(t, "index should be integer");
             break;
         default:
@@ -394,34 +536,33 @@ static void checkNode(TreeNode * t)
       }
       break;
     case StmtK:
-      switch (t->kind.stmt)
-      { case CompK:
-          // for scope post processing
-          free(scope[scopeidx].name);
-          scopeidx -= 1;
-          break;
-        case IfK:
+      switch (KIND(t))
+      { case IfK:
           // only integer condition is available
           // on parsing level, empty condition is filtered
-          if (t->child[0]->type != Integer)
-            simpleError(t->child[0],"if test is not integer");
+          if (TYPE(CHILD(t,0)) != Integer)
+            simpleError(CHILD(t,0),"if test is not integer");
           break;
         case WhileK:
           // only integer condition is available
           // on parsing level, empty condition is filtered
-          if (t->child[0]->type != Integer)
-            simpleError(t->child[0],"while test is not integer");
+          if (TYPE(CHILD(t,0)) != Integer)
+            simpleError(CHILD(t,0),"while test is not integer");
           break;
         case ReturnK:
-          // then scopeidx >= 1 and scope[1] is method scope,
-          // since function can be only declared on global scope by parser.
-          addr = st_lookup("global", scope[1].name);
-          if (t->child[0] == NULL)
-          { if (addr.bucket->fninfo->retn != Void)
+          // function can be only declared on global scope by parser,
+          // so the return is in the body of fnbucket.
+          sym = fnbucket;
+          // the function could not be entered, buildSymtab
+          // reported it
+          if (sym == NULL || sym->fninfo == NULL)
+            break;
+          if (CHILD(t,0) == NULLNODE)
+          { if (sym->fninfo->retn != Void)
               simpleError(t, "return nothing on non-void function");
           }
           // child[0] is not null
-          else if (t->child[0]->type != addr.bucket->fninfo->retn)
+          else if (TYPE(CHILD(t,0)) != sym->fninfo->retn)
             simpleError(t, "return type mismatch");
           break;
         default:
@@ -435,9 +576,180 @@ static void checkNode(TreeNode * t)
 }
 
 /* Procedure typeCheck performs type checking 
- * by a postorder syntax tree traversal
+ * by a postorder syntax tree traversal, reading
+ * the symbols bound by buildSymtab; it only runs
+ * when buildSymtab found no error
+ */
+void typeCheck(TreeNode syntaxTree)
+{ fnbucket = NULL;
+  traverse(syntaxTree,fnSetting,checkNode);
+}
+
+/* CheckJob is one global declaration to check, with
+ * the errors found in it.
+ */
+typedef struct {
+  TreeNode t;
+  Diagnostic * diags;
+  int ndiags;
+  int lost; // not all errors were kept
+} CheckJob;
+
+/* CheckPool is shared by the threads of one check. */
+typedef struct {
+  Ast * ast; // of the compiling thread
+  FILE * listing;
+  CheckJob * jobs;
+  int njobs;
+  int next; // next job to hand to a thread
+} CheckPool;
+
+/* Check the global declaration t and its body, in
+ * the order of typeCheck. The checks only read the
+ * symbols and set the types of the nodes below t,
+ * so declarations can be checked at the same time.
+ */
+static void checkDecl(TreeNode t)
+{ int i;
+  fnSetting(t);
+  for (i = 0; i < MAXCHILDREN; i++)
+    if (CHILD(t,i) != NULLNODE)
+      traverse(CHILD(t,i),nullProc,checkNode);
+  checkNode(t);
+}
+
+/* Check declarations until none are left, keeping
+ * the errors of each with it.
  */
-void typeCheck(TreeNode * syntaxTree)
-{ init_scope_info(INIT_LOC);
-  traverse(syntaxTree,scopeSetting,checkNode);
+static void * checkWorker(void * arg)
+{ CheckPool * pool = (CheckPool *) arg;
+  int i;
+  ast = pool->ast;
+  listing = pool->listing;
+  deferring = TRUE;
+  while ((i = __sync_fetch_and_add(&pool->next,1)) < pool->njobs)
+  { checkDecl(pool->jobs[i].t);
+    pool->jobs[i].diags = diags;
+    pool->jobs[i].ndiags = ndiags;
+    pool->jobs[i].lost = diagslost;
+    diags = NULL;
+    ndiags = 0;
+    diagcap = 0;
+    diagslost = FALSE;
+  }
+  deferring = FALSE;
+  return NULL;
+}
+
+/* Procedure typeCheckParallel performs typeCheck
+ * with the global declarations shared out among
+ * nthreads threads
+ */
+void typeCheckParallel(TreeNode syntaxTree, int nthreads)
+{ CheckPool pool;
+  pthread_t * threads;
+  TreeNode t;
+  int i, j, started = 0;
+  pool.njobs = 0;
+  for (t = syntaxTree; t != NULLNODE; t = SIBLING(t))
+    pool.njobs++;
+  if (nthreads > pool.njobs)
+    nthreads = pool.njobs;
+  if (nthreads <= 1)
+  { typeCheck(syntaxTree);
+    return;
+  }
+  pool.jobs = (CheckJob *) calloc(pool.njobs, sizeof(CheckJob));
+  threads = (pthread_t *) malloc(nthreads * sizeof(pthread_t));
+  // without memory for the threads, check here
+  if (pool.jobs == NULL || threads == NULL)
+  { free(pool.jobs);
+    free(threads);
+    typeCheck(syntaxTree);
+    return;
+  }
+  for (t = syntaxTree, i = 0; t != NULLNODE; t = SIBLING(t))
+    pool.jobs[i++].t = t;
+  pool.ast = ast;
+  pool.listing = listing;
+  pool.next = 0;
+  for (i = 0; i < nthreads; i++)
+    if (pthread_create(&threads[started],NULL,checkWorker,&pool) == 0)
+      started++;
+  if (started == 0)
+    checkWorker(&pool);
+  for (i = 0; i < started; i++)
+    pthread_join(threads[i],NULL);
+  // report in source order; the checks set the same
+  // types again, so a job whose errors were lost is
+  // simply checked here
+  for (i = 0; i < pool.njobs; i++)
+  { if (pool.jobs[i].lost)
+      checkDecl(pool.jobs[i].t);
+    else
+      for (j = 0; j < pool.jobs[i].ndiags; j++)
+        printError(pool.jobs[i].diags[j].t, pool.jobs[i].diags[j].message,
+                   pool.jobs[i].diags[j].named);
+    free(pool.jobs[i].diags);
+  }
+  free(pool.jobs);
+  free(threads);
+}
+
+/* Forget the errors held back by the one-pass analysis. */
+static void drop_diags(void)
+{ free(diags);
+  diags = NULL;
+  ndiags = 0;
+  diagcap = 0;
+  diagslost = FALSE;
+}
+
+/* Postorder of the one-pass analysis: the node is
+ * checked as soon as its subtree is, with the errors
+ * held back until the symbol table is known to be
+ * free of errors, since typeCheck would not run
+ * otherwise.
+ */
+static void postInsertAndCheck(TreeNode t)
+{ postInsert(t);
+  deferring = TRUE;
+  checkNode(t);
+  deferring = FALSE;
+}
+
+/* Preorder of the one-pass analysis. */
+static void insertAndSet(TreeNode t)
+{ insertNode(t);
+  fnSetting(t);
+}
+
+/* Function buildAndCheck does buildSymtab and
+ * the checks of typeCheck in a single traversal
+ */
+void buildAndCheck(TreeNode syntaxTree)
+{ drop_diags();
+  fnbucket = NULL;
+  if (!init_state())
+    return;
+  traverse(syntaxTree,insertAndSet,postInsertAndCheck);
+  free_scope_info();
+  // typeCheck would not have run
+  if (Error)
+    drop_diags();
+  print_tables();
+}
+
+/* Procedure reportChecks reports the errors found
+ * by the checks of buildAndCheck
+ */
+void reportChecks(void)
+{ int i;
+  for (i = 0; i < ndiags; i++)
+    printError(diags[i].t, diags[i].message, diags[i].named);
+  if (diagslost)
+  { fprintf(listing,"Out of memory error in type check\n");
+    Error = TRUE;
+  }
+  drop_diags();
 }
@@ -11,11 +11,32 @@
 /* Function buildSymtab constructs the symbol 
  * table by preorder traversal of the syntax tree
  */
-void buildSymtab(TreeNode *);
+void buildSymtab(TreeNode);
 
 /* Procedure typeCheck performs type checking 
  * by a postorder syntax tree traversal
  */
-void typeCheck(TreeNode *);
+void typeCheck(TreeNode);
+
+/* Procedure typeCheckParallel performs typeCheck
+ * with the function bodies checked on up to
+ * nthreads threads; the errors are reported in
+ * source order, as typeCheck reports them
+ */
+void typeCheckParallel(TreeNode, int nthreads);
+
+/* Function buildAndCheck does buildSymtab and
+ * the checks of typeCheck in the same traversal,
+ * holding back their errors; it prints what
+ * buildSymtab prints
+ */
+void buildAndCheck(TreeNode);
+
+/* Procedure reportChecks reports the errors held
+ * back by buildAndCheck, in the order typeCheck
+ * reports them; only call it when buildAndCheck
+ * found no symbol table error
+ */
+void reportChecks(void);
 
 #endif
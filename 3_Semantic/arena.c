@@ -0,0 +1,90 @@
+/****************************************************/
+/* File: arena.c                                    */
+/* Arena allocator for the C- compiler              */
+/****************************************************/
+
+#include <stdlib.h>
+#include "arena.h"
+
+/* the header is padded so that block memory
+   starts aligned */
+#define HEADER ((sizeof(ArenaBlock) + ARENAALIGN - 1) & ~(size_t) (ARENAALIGN - 1))
+
+/* Function arena_new returns an empty arena */
+Arena * arena_new(void)
+{ return (Arena *) calloc(1, sizeof(Arena));
+}
+
+/* nextBlock moves a to the block after the current
+   one, adding a block there unless it holds size
+   bytes; returns 0 if out of memory */
+static int nextBlock(Arena * a, size_t size)
+{ ArenaBlock * b = a->block != NULL ? a->block->next : a->first;
+  if (b == NULL || b->size < size)
+  { size_t n = size > ARENABLOCK ? size : ARENABLOCK;
+    ArenaBlock * nb = (ArenaBlock *) malloc(HEADER + n);
+    if (nb == NULL)
+      return 0;
+    nb->size = n;
+    nb->next = b;
+    if (a->block != NULL)
+      a->block->next = nb;
+    else
+      a->first = nb;
+    b = nb;
+  }
+  a->block = b;
+  a->next = (char *) b + HEADER;
+  a->limit = a->next + b->size;
+  return 1;
+}
+
+/* Function arena_alloc returns size bytes */
+void * arena_alloc(Arena * a, size_t size)
+{ char * p;
+  size = (size + ARENAALIGN - 1) & ~(size_t) (ARENAALIGN - 1);
+  if ((a->block == NULL || size > (size_t) (a->limit - a->next)) &&
+      !nextBlock(a, size))
+    return NULL;
+  p = a->next;
+  a->next += size;
+  return p;
+}
+
+/* Function arena_mark returns the state of a */
+ArenaMark arena_mark(Arena * a)
+{ ArenaMark mark;
+  mark.block = a->block;
+  mark.next = a->next;
+  mark.limit = a->limit;
+  return mark;
+}
+
+/* Procedure arena_release goes back to mark; the
+   blocks after its block stay linked for reuse */
+void arena_release(Arena * a, ArenaMark mark)
+{ a->block = mark.block;
+  a->next = mark.next;
+  a->limit = mark.limit;
+}
+
+/* Procedure arena_reset releases all allocations */
+void arena_reset(Arena * a)
+{ a->block = NULL;
+  a->next = NULL;
+  a->limit = NULL;
+}
+
+/* Procedure arena_free releases the arena */
+void arena_free(Arena * a)
+{ ArenaBlock * b;
+  if (a == NULL)
+    return;
+  b = a->first;
+  while (b != NULL)
+  { ArenaBlock * next = b->next;
+    free(b);
+    b = next;
+  }
+  free(a);
+}
@@ -0,0 +1,77 @@
+/****************************************************/
+/* File: arena.h                                    */
+/* Arena allocator for the C- compiler              */
+/* Syntax tree nodes, names and symbol table        */
+/* records live as long as one compilation, so they */
+/* are carved out of large blocks and released     */
+/* together                                         */
+/****************************************************/
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include <stddef.h>
+
+/* ARENABLOCK is the usual size of an arena block */
+#define ARENABLOCK (64 * 1024)
+
+/* ARENAALIGN is the alignment of every allocation */
+#define ARENAALIGN 8
+
+/* ArenaBlock heads each block of memory */
+typedef struct ArenaBlockRec
+   { struct ArenaBlockRec * next;
+     size_t size; /* bytes after the header */
+   } ArenaBlock;
+
+/* An Arena hands out memory from its current block
+ * by moving next up to limit. Blocks are kept when
+ * the arena is reset, so a later compilation reuses
+ * them instead of growing the process.
+ */
+typedef struct
+   { ArenaBlock * first; /* all blocks, in the order used */
+     ArenaBlock * block; /* block being filled, NULL if none */
+     char * next; /* first free byte of block */
+     char * limit; /* end of block */
+   } Arena;
+
+/* ArenaMark is the state of an arena at some
+ * point, see arena_release
+ */
+typedef struct
+   { ArenaBlock * block;
+     char * next;
+     char * limit;
+   } ArenaMark;
+
+/* Function arena_new returns an empty arena,
+ * or NULL if out of memory
+ */
+Arena * arena_new(void);
+
+/* Function arena_alloc returns size bytes of
+ * uninitialized memory, or NULL if out of memory
+ */
+void * arena_alloc(Arena * a, size_t size);
+
+/* Procedure arena_reset releases everything
+ * allocated from a at once, keeping its blocks
+ */
+void arena_reset(Arena * a);
+
+/* Function arena_mark returns the state of a */
+ArenaMark arena_mark(Arena * a);
+
+/* Procedure arena_release releases everything
+ * allocated from a after mark was taken, keeping
+ * its blocks
+ */
+void arena_release(Arena * a, ArenaMark mark);
+
+/* Procedure arena_free returns the blocks of a
+ * and a itself to the system
+ */
+void arena_free(Arena * a);
+
+#endif
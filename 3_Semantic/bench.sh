@@ -0,0 +1,66 @@
+#!/bin/sh
+# bench.sh: parser scaling benchmark run by make bench
+#
+# Parses generated C- sources with cminus_parse and prints
+# one CSV row per run. Each source is one long list of a
+# shape: top-level declarations (decl), statements of one
+# function (stmt) or arguments of one call (arg). With lists
+# built in linear time, us_per_item stays about the same as
+# the count grows.
+# BENCH_COUNTS lists the list lengths, BENCH_SHAPES the
+# shapes; sources are kept in BENCH_DIR between runs.
+
+counts=${BENCH_COUNTS:-"25000 50000 100000 200000 400000"}
+shapes=${BENCH_SHAPES:-"decl stmt arg"}
+dir=${BENCH_DIR:-/tmp/cminus-parse-bench}
+
+# gen shape count writes the source; identifiers are
+# letters only in C-, so item i is named by its digits
+# in base 26 after a g, which starts no reserved word
+gen() {
+  awk -v shape="$1" -v n="$2" '
+    function name(i,  s) { s = ""
+      do { s = sprintf("%c", 97 + i % 26) s; i = int(i / 26) } while (i > 0)
+      return "g" s }
+    BEGIN {
+      if (shape == "decl") {
+        for (i = 0; i < n; i++) printf "int %s;\n", name(i)
+        print "void main(void) { }"
+      } else if (shape == "stmt") {
+        print "void main(void)\n{ int x;"
+        for (i = 0; i < n; i++) print "  x = x + 1;"
+        print "}"
+      } else {
+        print "void main(void)\n{ int x;\n  output(x"
+        for (i = 1; i < n; i++) print "  , x"
+        print "  );\n}"
+      }
+    }'
+}
+
+# now prints the time in nanoseconds
+now() {
+  date +%s%N
+}
+
+mkdir -p "$dir" || exit 1
+echo "shape,count,bytes,seconds,us_per_item"
+for shape in $shapes; do
+  for n in $counts; do
+    input="$dir/$shape-$n.cm"
+    if [ ! -s "$input" ]; then
+      gen "$shape" "$n" > "$input.tmp" && mv "$input.tmp" "$input" || exit 1
+    fi
+    start=$(now)
+    ./cminus_parse "$input" > "$dir/out" || exit 1
+    end=$(now)
+    if grep -q "error" "$dir/out"; then
+      cat "$dir/out" >&2
+      exit 1
+    fi
+    awk -v shape="$shape" -v n="$n" -v bytes="$(wc -c < "$input")" \
+      -v ns="$((end - start))" \
+      'BEGIN { printf "%s,%d,%d,%.6f,%.4f\n", shape, n, bytes, ns / 1e9, ns / 1e3 / n }'
+  done
+done
+rm -f "$dir/out"
@@ -10,19 +10,67 @@
 #include "util.h"
 #include "scan.h"
 #include "parse.h"
+#include "outbuf.h"
 
-#define YYSTYPE TreeNode *
+/* a node, except for type_spec, which gives an
+ * ExpType, and the operator rules, which give the
+ * TokenType of the operator
+ */
+#define YYSTYPE TreeNode
+/* deeply nested sources need more than the default
+ * parser stack, which grows on the heap up to this
+ */
+#define YYMAXDEPTH 10000000
 #define MAXNAMESAVING 30
-static char * savedName[MAXNAMESAVING]; /* for use in assignments */
-static int nameidx;
-static int savedNum;     /* for use in array assignments */
-static int savedLineNo;  /* ditto */
-static TreeNode * savedTree; /* stores syntax tree for later return */
+/* per thread, as the other state of a compilation */
+static __thread char * savedName[MAXNAMESAVING]; /* for use in assignments */
+static __thread int nameidx;
+static __thread int savedNum;     /* for use in array assignments */
+static __thread int savedPos;  /* ditto */
+static __thread TreeNode savedTree; /* stores syntax tree for later return */
+static __thread TokenStream * tokens; /* token stream of the whole source */
+static __thread int tokpos; /* index of the last token read by yylex */
+
+/* lexeme(back) returns the slice of the token back
+ * positions before the last one read by yylex;
+ * lexeme(1) is the token in front of the lookahead
+ */
+static TokenSlice lexeme(int back);
+
+/* The list rules prepend each element, which is a
+ * single node, so that a list is built in linear
+ * time; the rule using the list puts it back in
+ * source order with reverseList.
+ */
+static TreeNode prepend(TreeNode list, TreeNode t)
+{ if (t == NULLNODE)
+    return list;
+  SIBLING(t) = list;
+  return t;
+}
+
+/* reverseList reverses the sibling chain of list
+ * and ends it with tail
+ */
+static TreeNode reverseList(TreeNode list, TreeNode tail)
+{ while (list != NULLNODE)
+  { TreeNode next = SIBLING(list);
+    SIBLING(list) = tail;
+    tail = list;
+    list = next;
+  }
+  return tail;
+}
 
-int yylex(void);
+int yylex(YYSTYPE * lvalp);
 
 %}
 
+/* keep the parser state in yyparse, so that threads
+ * can parse at the same time
+ */
+%define api.pure
+
 %token IF ELSE WHILE RETURN INT VOID
 %token ID NUM 
 %token ASSIGN EQ NE LT LE GT GE PLUS MINUS TIMES OVER LPAREN RPAREN LBRACE RBRACE LCURLY RCURLY SEMI COMMA
@@ -31,150 +79,93 @@ int yylex(void);
 %% /* Grammar for TINY */
 
 program     : decl_list
-                { savedTree = $1; } 
+                { savedTree = reverseList($1,NULLNODE); }
             ;
-decl_list   : decl_list decl
-                { YYSTYPE t = $1;
-                  if (t != NULL)
-                  { while (t->sibling != NULL)
-                      t = t->sibling;
-                    /* $2 null check is unnecessary since decl is not nullable. */
-                    t->sibling = $2;
-                    $$ = $1;
-                  }
-                  else $$ = $2;
-                }
+decl_list   : decl_list decl { $$ = prepend($1,$2); }
             | decl { $$ = $1; }
             ;
 decl        : var_decl { $$ = $1; }
             | fn_decl  { $$ = $1; }
             ;
 var_decl    : type_spec
-              ID { savedName[nameidx++] = copyString(tokenString[1 - current]);
-                   savedLineNo = lineno; }
+              ID { savedName[nameidx++] = internSlice(lexeme(1));
+                   savedPos = srcpos; }
               SEMI
                 { $$ = newDeclNode(VarK);
-                  $$->attr.name = savedName[--nameidx];
-                  $$->lineno = savedLineNo;
-                  $$->type = $1->type;
-                  free($1);
+                  ATTR($$).name = savedName[--nameidx];
+                  POS($$) = savedPos;
+                  TYPE($$) = $1;
                 }
             | type_spec
-              ID { savedName[nameidx++] = copyString(tokenString[1 - current]);
-                   savedLineNo = lineno; }
+              ID { savedName[nameidx++] = internSlice(lexeme(1));
+                   savedPos = srcpos; }
               LBRACE
-              NUM { savedNum = atoi(tokenString[current]); }
+              NUM { savedNum = sliceNum(lexeme(0)); }
               RBRACE SEMI
-                { $$ = newDeclNode(VarK);
-                  $$->attr.name = savedName[--nameidx];
-                  $$->lineno = savedLineNo;
-                  $$->type = $1->type;
-                  $$->child[0] = newExpNode(ConstK);
-                  $$->child[0]->attr.val = savedNum;
-                  free($1);
+                { TreeNode size;
+                  $$ = newDeclNode(VarK);
+                  ATTR($$).name = savedName[--nameidx];
+                  POS($$) = savedPos;
+                  TYPE($$) = $1;
+                  size = newExpNode(ConstK);
+                  ATTR(size).val = savedNum;
+                  CHILD($$,0) = size;
                 }
             ;
-type_spec   : INT { $$ = newExpNode(IdK);
-                    $$->type = Integer; }
-            | VOID { $$ = newExpNode(IdK);
-                     $$->type = Void; }
+type_spec   : INT { $$ = Integer; }
+            | VOID { $$ = Void; }
             ;
-fn_decl     : type_spec ID { savedName[nameidx++] = copyString(tokenString[1 - current]);
-                             savedLineNo = lineno; }
+fn_decl     : type_spec ID { savedName[nameidx++] = internSlice(lexeme(1));
+                             savedPos = srcpos; }
               LPAREN params RPAREN comp_stmt
                 { $$ = newDeclNode(FnK);
-                  $$->child[0] = $5;
-                  $$->child[1] = $7;
-                  $$->attr.name = savedName[--nameidx];
-                  $$->lineno = savedLineNo;
-                  $$->type = $1->type;
-                  free($1);
+                  CHILD($$,0) = $5;
+                  CHILD($$,1) = $7;
+                  ATTR($$).name = savedName[--nameidx];
+                  POS($$) = savedPos;
+                  TYPE($$) = $1;
                 }
             ;
-params      : param_list { $$ = $1; }
+params      : param_list { $$ = reverseList($1,NULLNODE); }
             | VOID
                 { $$ = newDeclNode(ParamK);
-                  $$->attr.name = "(null)";
-                  $$->lineno = lineno;
-                  $$->type = Void;
+                  ATTR($$).name = internString("(null)");
+                  POS($$) = srcpos;
+                  TYPE($$) = Void;
                 }
             ;
-param_list  : param_list COMMA param
-                { YYSTYPE t = $1;
-                  if (t != NULL)
-                  { while (t->sibling != NULL)
-                      t = t->sibling;
-                    /* $3 null check is unnecessary since param is not nullable. */
-                    t->sibling = $3;
-                    $$ = $1;
-                  }
-                  else $$ = $3;
-                }
+param_list  : param_list COMMA param { $$ = prepend($1,$3); }
             | param { $$ = $1; }
             ;
 param       : type_spec ID
                 { $$ = newDeclNode(ParamK);
-                  $$->attr.name = copyString(tokenString[1 - current]);
-                  $$->lineno = lineno;
-                  $$->type = $1->type;
-                  free($1);
+                  ATTR($$).name = internSlice(lexeme(1));
+                  POS($$) = srcpos;
+                  TYPE($$) = $1;
                 }
-            | type_spec ID { savedName[nameidx++] = copyString(tokenString[1 - current]);
-                             savedLineNo = lineno; }
+            | type_spec ID { savedName[nameidx++] = internSlice(lexeme(1));
+                             savedPos = srcpos; }
               LBRACE RBRACE
-                { $$ = newDeclNode(ParamK);
-                  $$->attr.name = savedName[--nameidx];
-                  $$->lineno = savedLineNo;
-                  $$->type = $1->type;
-                  $$->child[0] = newExpNode(ConstK);
-                  $$->child[0]->attr.val = -1;
-                  free($1);
+                { TreeNode size;
+                  $$ = newDeclNode(ParamK);
+                  ATTR($$).name = savedName[--nameidx];
+                  POS($$) = savedPos;
+                  TYPE($$) = $1;
+                  size = newExpNode(ConstK);
+                  ATTR(size).val = -1;
+                  CHILD($$,0) = size;
                 }
             ;
 comp_stmt   : LCURLY local_decl stmt_list RCURLY
                 { $$ = newStmtNode(CompK);
-                  if ($2 == NULL)
-                    $$->child[0] = $3;
-                  else if ($3 == NULL)
-                   $$->child[0] = $2;
-                  else {
-                    YYSTYPE t = $2;
-                    while (t->sibling != NULL)
-                      t = t->sibling;
-                    t->sibling = $3;
-                    $$->child[0] = $2;
-                  }
+                  CHILD($$,0) = reverseList($2,reverseList($3,NULLNODE));
                 }
             ;
-local_decl  : local_decl var_decl
-                { if ($1 == NULL)
-                    $$ = $2;
-                  else if ($2 == NULL)
-                    $$ = $1;
-                  else {
-                    YYSTYPE t = $1;
-                    while (t->sibling != NULL)
-                      t = t->sibling;
-                    t->sibling = $2;
-                    $$ = $1;
-                  }
-                }
-            | /* empty */ { $$ = NULL; }
+local_decl  : local_decl var_decl { $$ = prepend($1,$2); }
+            | /* empty */ { $$ = NULLNODE; }
             ;
-stmt_list   : stmt_list stmt
-                { if ($1 == NULL)
-                    $$ = $2;
-                  else if ($2 == NULL)
-                    $$ = $1;
-                  else {
-                    YYSTYPE t = $1;
-                    while (t->sibling != NULL)
-                      t = t->sibling;
-                    t->sibling = $2;
-                    $$ = $1;
-                  }
-                }
-            | /* empty */ { $$ = NULL; }
+stmt_list   : stmt_list stmt { $$ = prepend($1,$2); }
+            | /* empty */ { $$ = NULLNODE; }
             ;
 stmt        : expr_stmt { $$ = $1; }
             | comp_stmt { $$ = $1; }
@@ -183,137 +174,168 @@ stmt        : expr_stmt { $$ = $1; }
             | return_stmt { $$ = $1; }
             ;
 expr_stmt   : expr SEMI { $$ = $1; }
-            | SEMI { $$ = NULL; }
+            | SEMI { $$ = NULLNODE; }
             ;
 if_stmt     : IF LPAREN expr RPAREN stmt
                 { $$ = newStmtNode(IfK);
-                  $$->child[0] = $3;
-                  $$->child[1] = $5;
+                  CHILD($$,0) = $3;
+                  CHILD($$,1) = $5;
                 }
             | IF LPAREN expr RPAREN stmt ELSE stmt
                 { $$ = newStmtNode(IfK);
-                  $$->child[0] = $3;
-                  $$->child[1] = $5;
-                  $$->child[2] = $7;
+                  CHILD($$,0) = $3;
+                  CHILD($$,1) = $5;
+                  CHILD($$,2) = $7;
                 }
             ;
 while_stmt  : WHILE LPAREN expr RPAREN stmt
                 { $$ = newStmtNode(WhileK);
-                  $$->child[0] = $3;
-                  $$->child[1] = $5;
+                  CHILD($$,0) = $3;
+                  CHILD($$,1) = $5;
                 }
             ;
 return_stmt : RETURN SEMI { $$ = newStmtNode(ReturnK); }
             | RETURN expr SEMI
                 { $$ = newStmtNode(ReturnK);
-                  $$->child[0] = $2;
+                  CHILD($$,0) = $2;
                 }
             ;
 expr        : var ASSIGN expr
                 { $$ = newExpNode(AssignK);
-                  $$->child[0] = $1;
-                  $$->child[1] = $3;
+                  CHILD($$,0) = $1;
+                  CHILD($$,1) = $3;
                 }
             | simple_expr { $$ = $1; }
             ;
 var         : ID 
                 { $$ = newExpNode(IdK);
-                  $$->attr.name = copyString(tokenString[1 - current]);
+                  ATTR($$).name = internSlice(lexeme(1));
                 }
-            | ID { savedName[nameidx++] = copyString(tokenString[1 - current]); } 
+            | ID { savedName[nameidx++] = internSlice(lexeme(1)); } 
               LBRACE expr RBRACE
-                { $$ = newExpNode(IdK);
-                  $$->attr.name = savedName[--nameidx];
-                  $$->child[0] = newExpNode(IdxK);
-                  $$->child[0]->child[0] = $4;
+                { TreeNode index;
+                  $$ = newExpNode(IdK);
+                  ATTR($$).name = savedName[--nameidx];
+                  index = newExpNode(IdxK);
+                  CHILD(index,0) = $4;
+                  CHILD($$,0) = index;
                 }
             ;
 simple_expr : add_expr relop add_expr
                 { $$ = newExpNode(OpK);
-                  $$->attr.op = $2->attr.op;
-                  $$->child[0] = $1;
-                  $$->child[1] = $3;
-                  free($2);
+                  ATTR($$).op = $2;
+                  CHILD($$,0) = $1;
+                  CHILD($$,1) = $3;
                 }
             | add_expr { $$ = $1; }
             ;
-relop       : LE { $$ = newOpNode(LE); }
-            | LT { $$ = newOpNode(LT); }
-            | GT { $$ = newOpNode(GT); }
-            | GE { $$ = newOpNode(GE); }
-            | EQ { $$ = newOpNode(EQ); }
-            | NE { $$ = newOpNode(NE); }
+relop       : LE { $$ = LE; }
+            | LT { $$ = LT; }
+            | GT { $$ = GT; }
+            | GE { $$ = GE; }
+            | EQ { $$ = EQ; }
+            | NE { $$ = NE; }
             ;
 add_expr    : add_expr addop term
                 { $$ = newExpNode(OpK);
-                  $$->attr.op = $2->attr.op;
-                  $$->child[0] = $1;
-                  $$->child[1] = $3;
-                  free($2);
+                  ATTR($$).op = $2;
+                  CHILD($$,0) = $1;
+                  CHILD($$,1) = $3;
                 }
             | term { $$ = $1; }
             ;
-addop       : PLUS { $$ = newOpNode(PLUS); }
-            | MINUS { $$ = newOpNode(MINUS); }
+addop       : PLUS { $$ = PLUS; }
+            | MINUS { $$ = MINUS; }
             ;
 term        : term mulop factor
                 { $$ = newExpNode(OpK);
-                  $$->attr.op = $2->attr.op;
-                  $$->child[0] = $1;
-                  $$->child[1] = $3;
-                  free($2);
+                  ATTR($$).op = $2;
+                  CHILD($$,0) = $1;
+                  CHILD($$,1) = $3;
                 }
             | factor { $$ = $1; }
             ;
-mulop       : TIMES { $$ = newOpNode(TIMES); }
-            | OVER { $$ = newOpNode(OVER); }
+mulop       : TIMES { $$ = TIMES; }
+            | OVER { $$ = OVER; }
             ;
 factor      : LPAREN expr RPAREN { $$ = $2; }
             | var { $$ = $1; }
             | call { $$ = $1; }
             | NUM
                 { $$ = newExpNode(ConstK);
-                  $$->attr.val = atoi(tokenString[current]);
+                  ATTR($$).val = sliceNum(lexeme(0));
                 }
             ;
-call        : ID { savedName[nameidx++] = copyString(tokenString[1 - current]); }
+call        : ID { savedName[nameidx++] = internSlice(lexeme(1)); }
               LPAREN args RPAREN
                 { $$ = newExpNode(CallK);
-                  $$->attr.name = savedName[--nameidx];
-                  $$->child[0] = $4;
+                  ATTR($$).name = savedName[--nameidx];
+                  CHILD($$,0) = $4;
                 }
             ;
-args        : arg_list { $$ = $1; }
-            | /* empty */ { $$ = NULL; }
+args        : arg_list { $$ = reverseList($1,NULLNODE); }
+            | /* empty */ { $$ = NULLNODE; }
             ;
-arg_list    : arg_list COMMA expr
-                { YYSTYPE t = $1;
-                  while (t->sibling != NULL)
-                    t = t->sibling;
-                  t->sibling = $3;
-                  $$ = $1;
-                }
+arg_list    : arg_list COMMA expr { $$ = prepend($1,$3); }
             | expr { $$ = $1; }
             ;
 %%
 
 int yyerror(char * message)
-{ fprintf(listing,"Syntax error at line %d: %s\n",lineno,message);
+{ char text[MAXTOKENLEN+1];
+  /* the column is only kept with the error, see SourceError */
+  noteError(lineOf(srcpos),columnOf(srcpos),message,NULL);
+  fprintf(listing,"Syntax error at line %d: %s\n",lineOf(srcpos),message);
   fprintf(listing,"Current token: ");
-  printToken(yychar,tokenString[current]);
+  printToken(tokens->kind[tokpos],sliceText(lexeme(0),text,sizeof(text)));
   Error = TRUE;
   return 0;
 }
 
-/* yylex calls getToken to make Yacc/Bison output
- * compatible with ealier versions of the TINY scanner
+static TokenSlice lexeme(int back)
+{ TokenSlice slice;
+  slice.offset = tokens->offset[tokpos - back];
+  slice.length = tokens->length[tokpos - back];
+  return slice;
+}
+
+/* yylex walks the token stream scanned up front
+ * by tokenizeAll, staying on the final ENDFILE;
+ * tokens have no value
  */
-int yylex(void)
-{ return getToken(); }
+int yylex(YYSTYPE * lvalp)
+{ if (tokpos < tokens->count - 1)
+    tokpos++;
+  srcpos = tokens->offset[tokpos];
+  if (TraceScan) {
+    char text[MAXTOKENLEN+1];
+    OutBuf * out = out_to(listing);
+    out_char(out,'\t');
+    out_int(out,lineOf(srcpos));
+    out_str(out,": ");
+    printToken(tokens->kind[tokpos],sliceText(lexeme(0),text,sizeof(text)));
+  }
+  return tokens->kind[tokpos];
+}
 
-TreeNode * parse(void)
-{ nameidx = 0;
+TreeNode parse(void)
+{ Scanner * s = newScanner(source,listing);
+  nameidx = 0;
+  if (s == NULL)
+  { fprintf(listing,"Out of memory error at line %d\n",lineOf(srcpos));
+    Error = TRUE;
+    return NULLNODE;
+  }
+  tokens = tokenizeAll(s);
+  freeScanner(s);
+  if (tokens == NULL)
+  { Error = TRUE;
+    return NULLNODE;
+  }
+  tokpos = -1;
   yyparse();
+  freeTokenStream(tokens);
+  tokens = NULL;
   return savedTree;
 }
 
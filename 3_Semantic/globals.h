@@ -14,6 +14,9 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <string.h>
+#include "srcmap.h"
+#include "arena.h"
+#include "intern.h"
 
 /* Yacc/Bison generates internally its own values
  * for the tokens. Other files can access these values
@@ -52,11 +55,18 @@
  */
 typedef int TokenType; 
 
-extern FILE* source; /* source code text file */
-extern FILE* listing; /* listing output text file */
-extern FILE* code; /* code text file for TM simulator */
+/* The state of a compilation is kept per thread,
+ * so that the threads of a batch compile files of
+ * their own (see main.c); the tracing flags below
+ * are shared
+ */
+extern __thread SourceMap* source; /* source code text */
+extern __thread Arena* arena; /* memory of the compilation */
+extern __thread NameTable* names; /* interned identifiers */
+extern __thread FILE* listing; /* listing output text file */
+extern __thread FILE* code; /* code text file for TM simulator */
 
-extern int lineno; /* source line number for listing */
+extern __thread int srcpos; /* source offset of the current token */
 
 /**************************************************/
 /***********   Syntax tree for parsing ************/
@@ -72,19 +82,59 @@ typedef enum {Void,Integer,Boolean,Function,Array} ExpType;
 
 #define MAXCHILDREN 3
 
-typedef struct treeNode
-   { struct treeNode * child[MAXCHILDREN];
-     struct treeNode * sibling;
-     int lineno;
-     NodeKind nodekind;
-     union { DeclKind decl;
-             StmtKind stmt;
-             ExpKind exp; } kind;
-     union { TokenType op;
-             int val;
-             char * name; } attr;
-     ExpType type; /* for type checking of exps */
-   } TreeNode;
+/* A tree node is the index of the node in the pools
+ * of the Ast; index NULLNODE is no node
+ */
+typedef int TreeNode;
+#define NULLNODE 0
+
+/* the fields read by every traversal, kept apart
+ * from the ones only some nodes need
+ */
+typedef struct
+   { unsigned char nodekind; /* NodeKind */
+     unsigned char kind; /* DeclKind, StmtKind or ExpKind */
+     unsigned char type; /* ExpType, for type checking of exps */
+     TreeNode child[MAXCHILDREN];
+     TreeNode sibling;
+   } NodeHot;
+
+typedef union
+   { TokenType op;
+     int val;
+     char * name; /* interned, see intern.h */
+   } NodeAttr;
+
+/* symbol table record, see symtab.h */
+struct BucketListRec;
+
+/* The node pools of a syntax tree, each indexed by
+ * node. They grow by reallocation, so a node field
+ * must not be assigned the result of a call that
+ * makes nodes: the field may move under it.
+ */
+typedef struct
+   { NodeHot * hot;
+     int * pos; /* source offset, see lineOf */
+     NodeAttr * attr;
+     struct BucketListRec ** sym; /* symbol bound to each
+                                     identifier and function,
+                                     made by buildSymtab */
+     int count; /* nodes made, NULLNODE included */
+     int capacity;
+   } Ast;
+
+extern __thread Ast* ast; /* syntax tree of the compilation */
+
+/* the fields of node t */
+#define NODEKIND(t) (ast->hot[t].nodekind)
+#define KIND(t) (ast->hot[t].kind)
+#define TYPE(t) (ast->hot[t].type)
+#define CHILD(t,i) (ast->hot[t].child[i])
+#define SIBLING(t) (ast->hot[t].sibling)
+#define POS(t) (ast->pos[t])
+#define ATTR(t) (ast->attr[t])
+#define SYM(t) (ast->sym[t])
 
 /**************************************************/
 /***********   Flags for tracing       ************/
@@ -119,5 +169,30 @@ extern int TraceAnalyze;
 extern int TraceCode;
 
 /* Error = TRUE prevents further passes if an error occurs */
-extern int Error; 
+extern __thread int Error; 
+
+/* SourceError is an error of the source program as
+ * the listing reports it, with the column of a syntax
+ * error, which the listing leaves out; see noteError
+ */
+typedef struct
+   { int line;
+     int column; /* of a syntax error; 0 for a semantic
+                    error, whose node only knows the
+                    token after it */
+     const char * message;
+     const char * name; /* identifier in error, NULL if none */
+   } SourceError;
+
+/* ErrorList holds the errors of a compilation */
+typedef struct
+   { SourceError * items;
+     int count;
+     int capacity;
+   } ErrorList;
+
+/* errors = NULL unless the errors are also wanted
+ * as records, as by the library (see libcminus.h)
+ */
+extern __thread ErrorList * errors;
 #endif
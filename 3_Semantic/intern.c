@@ -0,0 +1,105 @@
+/****************************************************/
+/* File: intern.c                                   */
+/* Interned names for the C- compiler               */
+/****************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "intern.h"
+
+/* NAMESLOTS is the first size of a name table */
+#define NAMESLOTS 1024
+
+/* Function names_new returns an empty table */
+NameTable * names_new(Arena * a)
+{ NameTable * t = (NameTable *) malloc(sizeof(NameTable));
+  if (t == NULL)
+    return NULL;
+  t->slots = (NameRec **) calloc(NAMESLOTS, sizeof(NameRec *));
+  if (t->slots == NULL)
+  { free(t);
+    return NULL;
+  }
+  t->arena = a;
+  t->size = NAMESLOTS;
+  t->count = 0;
+  return t;
+}
+
+/* name_hash is FNV-1a over the characters */
+unsigned name_hash(const char * text, int len)
+{ unsigned h = 2166136261u;
+  int i;
+  for (i = 0; i < len; i++)
+  { h ^= (unsigned char) text[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+/* grow doubles the slots of t, moving each record
+   by its stored hash; returns 0 if out of memory */
+static int grow(NameTable * t)
+{ int size = t->size * 2;
+  NameRec ** slots = (NameRec **) calloc(size, sizeof(NameRec *));
+  int i, j;
+  if (slots == NULL)
+    return 0;
+  for (i = 0; i < t->size; i++)
+    if (t->slots[i] != NULL)
+    { j = t->slots[i]->hash & (size - 1);
+      while (slots[j] != NULL)
+        j = (j + 1) & (size - 1);
+      slots[j] = t->slots[i];
+    }
+  free(t->slots);
+  t->slots = slots;
+  t->size = size;
+  return 1;
+}
+
+/* Function intern returns the interned name of text */
+char * intern(NameTable * t, const char * text, int len)
+{ unsigned h = name_hash(text, len);
+  int i = h & (t->size - 1);
+  NameRec * r;
+  while ((r = t->slots[i]) != NULL)
+  { if (r->hash == h && r->length == len &&
+        memcmp(r->text, text, len) == 0)
+      return r->text;
+    i = (i + 1) & (t->size - 1);
+  }
+  /* keep the table at most half full */
+  if (2 * (t->count + 1) > t->size)
+  { if (!grow(t))
+      return NULL;
+    i = h & (t->size - 1);
+    while (t->slots[i] != NULL)
+      i = (i + 1) & (t->size - 1);
+  }
+  r = (NameRec *) arena_alloc(t->arena, offsetof(NameRec,text) + len + 1);
+  if (r == NULL)
+    return NULL;
+  r->hash = h;
+  r->length = len;
+  r->bucket = -1;
+  memcpy(r->text, text, len);
+  r->text[len] = '\0';
+  t->slots[i] = r;
+  t->count++;
+  return r->text;
+}
+
+/* Procedure names_reset empties the table */
+void names_reset(NameTable * t)
+{ memset(t->slots, 0, t->size * sizeof(NameRec *));
+  t->count = 0;
+}
+
+/* Procedure names_free releases the table */
+void names_free(NameTable * t)
+{ if (t == NULL)
+    return;
+  free(t->slots);
+  free(t);
+}
@@ -0,0 +1,63 @@
+/****************************************************/
+/* File: intern.h                                   */
+/* Interned names for the C- compiler               */
+/* Each distinct identifier is kept once, with its  */
+/* hash, so the parser, the analyzer and the symbol */
+/* table share one copy and compare names by        */
+/* pointer instead of by their characters           */
+/****************************************************/
+
+#ifndef _INTERN_H_
+#define _INTERN_H_
+
+#include <stddef.h>
+#include "arena.h"
+
+/* NameRec holds an interned name; the name handed
+ * out is its text, so it prints like any string
+ */
+typedef struct
+   { unsigned hash; /* hash of the text, see name_hash */
+     int length;
+     int bucket; /* listing bucket of the name,
+                    -1 until symtab.c sets it */
+     char text[1]; /* NUL-terminated */
+   } NameRec;
+
+/* NAMEREC(name) is the record of an interned name */
+#define NAMEREC(name) ((NameRec *) ((name) - offsetof(NameRec,text)))
+
+/* NameTable maps texts to their records by open
+ * addressing; the records live in the arena
+ */
+typedef struct
+   { Arena * arena;
+     NameRec ** slots; /* size slots, NULL if empty */
+     int size; /* a power of two */
+     int count;
+   } NameTable;
+
+/* Function names_new returns an empty table whose
+ * names are allocated from a, or NULL if out of memory
+ */
+NameTable * names_new(Arena * a);
+
+/* Function intern returns the interned name with
+ * the len characters of text, or NULL if out of memory
+ */
+char * intern(NameTable * t, const char * text, int len);
+
+/* Function name_hash returns the hash intern gives
+ * the len characters of text
+ */
+unsigned name_hash(const char * text, int len);
+
+/* Procedure names_reset forgets every name, for
+ * use when the arena of the names is reset
+ */
+void names_reset(NameTable * t);
+
+/* Procedure names_free releases the table */
+void names_free(NameTable * t);
+
+#endif
@@ -0,0 +1,325 @@
+/****************************************************/
+/* File: libcminus.c                                */
+/* Library interface of the C- compiler             */
+/****************************************************/
+
+#include "globals.h"
+
+/* set NO_PARSE to TRUE to get a scanner-only compiler */
+#ifndef NO_PARSE
+#define NO_PARSE FALSE
+#endif
+/* set NO_ANALYZE to TRUE to get a parser-only compiler;
+ * make builds one as cminus_parse for the benchmark
+ */
+#ifndef NO_ANALYZE
+#define NO_ANALYZE FALSE
+#endif
+/* set ONE_PASS_ANALYZE to FALSE to build the symbol
+ * table and check the types in two traversals; it
+ * only applies to compilations on one thread, those
+ * on more always take two, see compileSource
+ */
+#ifndef ONE_PASS_ANALYZE
+#define ONE_PASS_ANALYZE TRUE
+#endif
+
+/* set NO_CODE to TRUE to get a compiler that does not
+ * generate code
+ */
+#define NO_CODE TRUE
+
+#include "util.h"
+#include "libcminus.h"
+#if NO_PARSE
+#include "scan.h"
+#else
+#include "parse.h"
+#if !NO_ANALYZE
+#include "analyze.h"
+#if !NO_CODE
+#include "cgen.h"
+#endif
+#endif
+#endif
+
+/* allocate global variables, one set per
+ * compiling thread
+ */
+__thread int srcpos = 0;
+__thread SourceMap * source;
+__thread Arena * arena;
+__thread NameTable * names;
+__thread Ast * ast;
+__thread FILE * listing;
+__thread FILE * code;
+
+/* allocate and set tracing flags */
+int EchoSource = FALSE;
+int TraceScan = FALSE;
+int TraceParse = FALSE;
+int TraceAnalyze = TRUE;
+int TraceCode = FALSE;
+
+__thread int Error = FALSE;
+__thread ErrorList * errors = NULL;
+
+/* WARMNAMES bounds the names cm_recompile keeps
+ * from one compilation to the next
+ */
+#define WARMNAMES (1 << 16)
+
+/* the result whose global scope is kept, see
+ * global_keep
+ */
+static __thread CmResult * keptFor = NULL;
+
+/* newCompile starts a compilation of source, with
+ * memory of its own; returns FALSE if out of memory
+ */
+static int newCompile(void)
+{ global_drop();
+  keptFor = NULL;
+  srcpos = 0;
+  Error = FALSE;
+  arena = arena_new();
+  ast = newAst();
+  names = arena!=NULL ? names_new(arena) : NULL;
+  if (arena==NULL || ast==NULL || names==NULL)
+  { freeAst(ast);
+    arena_free(arena);
+    ast = NULL;
+    arena = NULL;
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/* endCompile releases the memory of the compilation */
+static void endCompile(void)
+{ freeAst(ast);
+  names_free(names);
+  arena_free(arena);
+  ast = NULL;
+  names = NULL;
+  arena = NULL;
+}
+
+/* runPasses runs the passes of the compiler over
+ * source and fills in the tree and tables of r,
+ * if given
+ */
+static void runPasses(const char * pgm, int nthreads, CmResult * r)
+{ TreeNode syntaxTree;
+#if !NO_PARSE && !NO_ANALYZE
+  int onePass = ONE_PASS_ANALYZE && nthreads == 1;
+#endif
+  fprintf(listing,"C-MINUS COMPILATION: %s\n",pgm);
+#if NO_PARSE
+  while (getToken()!=ENDFILE);
+#else
+  syntaxTree = parse();
+  if (r != NULL) r->tree = syntaxTree;
+  if (TraceParse) {
+    fprintf(listing,"\nSyntax tree:\n");
+    printTree(syntaxTree);
+  }
+#if !NO_ANALYZE
+  if (! Error)
+  { if (TraceAnalyze) fprintf(listing,"\nBuilding Symbol Table...\n");
+    if (onePass) buildAndCheck(syntaxTree);
+    else buildSymtab(syntaxTree);
+    if (r != NULL) r->globals = global_scope();
+  }
+  if (! Error)
+  { if (TraceAnalyze) fprintf(listing,"\nChecking Types...\n");
+    if (onePass) reportChecks();
+    else typeCheckParallel(syntaxTree,nthreads);
+    if (TraceAnalyze) fprintf(listing,"\nType Checking Finished\n");
+  }
+#if !NO_CODE
+  if (! Error)
+  { char * codefile;
+    int fnlen = strcspn(pgm,".");
+    codefile = (char *) calloc(fnlen+4, sizeof(char));
+    strncpy(codefile,pgm,fnlen);
+    strcat(codefile,".tm");
+    code = fopen(codefile,"w");
+    if (code == NULL)
+    { fprintf(listing,"Unable to open %s\n",codefile);
+      Error = TRUE;
+    }
+    else
+    { codeGen(syntaxTree,codefile);
+      fclose(code);
+    }
+    free(codefile);
+  }
+#endif
+#endif
+#endif
+}
+
+/* Function compileSource compiles source to listing */
+int compileSource(const char * pgm, int nthreads)
+{ if (!newCompile())
+    return FALSE;
+  runPasses(pgm,nthreads,NULL);
+  endCompile();
+  return TRUE;
+}
+
+/* Function cm_compile compiles a source in memory;
+ * the listing goes to memory, the errors to the
+ * result as well
+ */
+CmResult * cm_compile(const char * name, const char * text, size_t size)
+{ CmResult * r = (CmResult *) calloc(1, sizeof(CmResult));
+  ErrorList list = { NULL, 0, 0 };
+  FILE * out = NULL;
+  if (r == NULL)
+    return NULL;
+  r->source = srcmap_mem(text,size);
+  if (r->source != NULL)
+    out = open_memstream(&r->listing,&r->listingSize);
+  if (out != NULL)
+  { source = r->source;
+    listing = out;
+    if (newCompile())
+    { errors = &list;
+      runPasses(name,1,r);
+      errors = NULL;
+      r->error = Error;
+      r->errors = list.items;
+      r->nerrors = list.count;
+      r->arena = arena;
+      r->names = names;
+      r->ast = ast;
+      fclose(out);
+      listing = NULL;
+      return r;
+    }
+    fclose(out);
+    listing = NULL;
+  }
+  srcmap_close(r->source);
+  free(r->listing);
+  free(r);
+  source = NULL;
+  return NULL;
+}
+
+/* warmUp empties the memory of r, selected, down
+ * to the global scope kept by global_keep, which is
+ * built first if it is not kept for r or the names
+ * have to go
+ */
+static void warmUp(CmResult * r)
+{ if (keptFor != r || names->count > WARMNAMES)
+  { arena_reset(arena);
+    arena_reset(names->arena);
+    names_reset(names);
+    /* without memory, init_state builds it again */
+    keptFor = global_keep() ? r : NULL;
+    r->mark = arena_mark(arena);
+  }
+  else
+    arena_release(arena, r->mark);
+  resetAst(ast);
+  srcpos = 0;
+  Error = FALSE;
+}
+
+/* Function cm_recompile compiles a source in memory
+ * into the memory of the last one
+ */
+CmResult * cm_recompile(CmResult * r, const char * name,
+                        const char * text, size_t size)
+{ SourceMap * src = srcmap_mem(text,size);
+  ErrorList list = { NULL, 0, 0 };
+  char * listingText = NULL;
+  size_t listingSize = 0;
+  FILE * out = NULL;
+  int made = FALSE;
+  if (src != NULL)
+    out = open_memstream(&listingText,&listingSize);
+  if (out != NULL && r == NULL)
+  { r = (CmResult *) calloc(1, sizeof(CmResult));
+    made = TRUE;
+    if (r != NULL)
+    { Arena * namesArena = arena_new();
+      r->arena = arena_new();
+      r->ast = newAst();
+      r->names = namesArena != NULL ? names_new(namesArena) : NULL;
+      if (r->names == NULL)
+        arena_free(namesArena);
+    }
+  }
+  if (out == NULL || r == NULL || r->arena == NULL ||
+      r->ast == NULL || r->names == NULL)
+  { if (out != NULL)
+      fclose(out);
+    free(listingText);
+    srcmap_close(src);
+    if (made)
+      cm_free(r);
+    return NULL;
+  }
+  cm_select(r);
+  srcmap_close(r->source);
+  r->source = source = src;
+  free(r->listing);
+  free(r->errors);
+  r->tree = NULLNODE;
+  r->globals = NULL;
+  warmUp(r);
+  listing = out;
+  errors = &list;
+  runPasses(name,1,r);
+  errors = NULL;
+  fclose(out);
+  listing = NULL;
+  r->listing = listingText;
+  r->listingSize = listingSize;
+  r->error = Error;
+  r->errors = list.items;
+  r->nerrors = list.count;
+  return r;
+}
+
+/* Procedure cm_select selects a compilation */
+void cm_select(CmResult * r)
+{ source = r->source;
+  arena = r->arena;
+  names = r->names;
+  ast = r->ast;
+}
+
+/* Procedure cm_free releases a compilation */
+void cm_free(CmResult * r)
+{ Arena * namesArena;
+  if (r == NULL)
+    return;
+  if (keptFor == r)
+  { global_drop();
+    keptFor = NULL;
+  }
+  /* forget it if selected */
+  if (ast == r->ast)
+  { source = NULL;
+    arena = NULL;
+    names = NULL;
+    ast = NULL;
+  }
+  /* recompiled names have an arena of their own */
+  namesArena = r->names != NULL ? r->names->arena : NULL;
+  freeAst(r->ast);
+  names_free(r->names);
+  if (namesArena != r->arena)
+    arena_free(namesArena);
+  arena_free(r->arena);
+  srcmap_close(r->source);
+  free(r->errors);
+  free(r->listing);
+  free(r);
+}
@@ -0,0 +1,78 @@
+/****************************************************/
+/* File: libcminus.h                                */
+/* Library interface of the C- compiler             */
+/* Compiles a source held in memory and hands back  */
+/* its syntax tree, symbol tables and errors; it    */
+/* neither writes to a file nor exits. The cminus   */
+/* program is a driver over the same library        */
+/****************************************************/
+
+#ifndef _LIBCMINUS_H_
+#define _LIBCMINUS_H_
+
+#include "globals.h"
+#include "symtab.h"
+
+/* CmResult is a compilation and what it produced;
+ * it owns its memory until cm_free
+ */
+typedef struct
+   { int error; /* the source has errors, or memory ran out */
+     SourceError * errors; /* in the order of the listing;
+                              only syntax errors have a
+                              column, the others 0 */
+     int nerrors;
+     TreeNode tree; /* syntax tree, read it after cm_select */
+     ScopeList globals; /* global scope of the symbol tables,
+                           NULL if they were not built; the
+                           names are interned in names */
+     char * listing; /* what cminus prints for the source */
+     size_t listingSize;
+     /* the state of the compilation, see cm_select */
+     SourceMap * source;
+     Arena * arena;
+     NameTable * names;
+     Ast * ast;
+     ArenaMark mark; /* the arena past the predefined
+                        functions, see cm_recompile */
+   } CmResult;
+
+/* Function cm_compile compiles the size bytes of
+ * text, called name in the listing, in the calling
+ * thread; the result is selected as by cm_select.
+ * Returns NULL if out of memory
+ */
+CmResult * cm_compile(const char * name, const char * text, size_t size);
+
+/* Function cm_recompile compiles text as cm_compile
+ * does, into r, a result of cm_recompile, reusing
+ * its memory: the arena and tree pools are emptied,
+ * the interned names and the global scope with the
+ * predefined functions are kept. r is made if NULL.
+ * A result is recompiled by one thread. Returns the
+ * result, or NULL if out of memory, leaving r as it
+ * was
+ */
+CmResult * cm_recompile(CmResult * r, const char * name,
+                        const char * text, size_t size);
+
+/* Procedure cm_select makes r the compilation of the
+ * calling thread, so that the macros of globals.h,
+ * lineOf and columnOf read its tree and source
+ */
+void cm_select(CmResult * r);
+
+/* Procedure cm_free releases a compilation */
+void cm_free(CmResult * r);
+
+/* Function compileSource compiles source to listing,
+ * both those of the calling thread; with nthreads 1
+ * the symbol table is built and the types checked in
+ * one traversal, with more the types are checked on
+ * up to nthreads threads once the table is built.
+ * Returns FALSE if out of memory. cminus runs it for
+ * each file; cm_compile always takes one thread
+ */
+int compileSource(const char * pgm, int nthreads);
+
+#endif
@@ -6,99 +6,291 @@
 /****************************************************/
 
 #include "globals.h"
+#include <unistd.h>
+#include <pthread.h>
 
-/* set NO_PARSE to TRUE to get a scanner-only compiler */
-#define NO_PARSE FALSE
-/* set NO_ANALYZE to TRUE to get a parser-only compiler */
-#define NO_ANALYZE FALSE
-
-/* set NO_CODE to TRUE to get a compiler that does not
- * generate code
+/* set CHECK_THREADS to the number of threads that
+ * check the function bodies of a single file, 0 for
+ * one per processor; with 1, the default, the tables
+ * are built and checked in one traversal, with more,
+ * the types are checked after the symbol table is
+ * built. The files of a batch are each checked in
+ * one traversal, a file to a thread
  */
-#define NO_CODE TRUE
+#ifndef CHECK_THREADS
+#define CHECK_THREADS 1
+#endif
 
 #include "util.h"
-#if NO_PARSE
-#include "scan.h"
-#else
-#include "parse.h"
-#if !NO_ANALYZE
-#include "analyze.h"
-#if !NO_CODE
-#include "cgen.h"
-#endif
-#endif
-#endif
+#include "libcminus.h"
+#include "serve.h"
 
-/* allocate global variables */
-int lineno = 0;
-FILE * source;
-FILE * listing;
-FILE * code;
+/* processors returns the number of processors online */
+static int processors(void)
+{ long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+  return ncpu < 1 ? 1 : ncpu;
+}
 
-/* allocate and set tracing flags */
-int EchoSource = FALSE;
-int TraceScan = FALSE;
-int TraceParse = FALSE;
-int TraceAnalyze = TRUE;
-int TraceCode = FALSE;
+/* fileName returns a copy of a source file name,
+ * adding the default extension, or NULL if out of
+ * memory
+ */
+static char * fileName(const char * arg)
+{ char * pgm = (char *) malloc(strlen(arg) + 5);
+  if (pgm == NULL)
+    return NULL;
+  strcpy(pgm,arg);
+  if (strchr (pgm, '.') == NULL)
+     strcat(pgm,".tny");
+  return pgm;
+}
 
-int Error = FALSE;
+/* CompileJob is one source file of a batch; its
+ * listing is kept in memory until it is written
+ */
+typedef struct
+   { char * pgm; /* source code file name */
+     SourceMap * source; /* opened by the reader, NULL if not found */
+     int failed; /* out of memory */
+     int done; /* compiled, the listing can be written */
+     char * text; /* listing of the file */
+     size_t size;
+   } CompileJob;
 
-int main( int argc, char * argv[] )
-{ TreeNode * syntaxTree;
-  char pgm[120]; /* source code file name */
-  if (argc != 2)
-    { fprintf(stderr,"usage: %s <filename>\n",argv[0]);
-      exit(1);
+/* Batch is shared by the threads of a batch: the
+ * reader opens the sources in order, the workers
+ * take them in order and the main thread writes
+ * the listings in order
+ */
+typedef struct
+   { CompileJob * jobs;
+     int njobs;
+     int read; /* jobs whose source the reader is done with */
+     int taken; /* jobs handed to a worker */
+     int window; /* sources the reader may open ahead of the workers */
+     pthread_mutex_t lock;
+     pthread_cond_t changed; /* signalled when a count above or
+                                the done of a job changes */
+   } Batch;
+
+/* readSources opens the sources of the batch, at
+ * most window of them ahead of the workers. The line
+ * index is built here, which also brings the text
+ * into memory before a worker needs it.
+ */
+static void * readSources(void * arg)
+{ Batch * b = (Batch *) arg;
+  int i;
+  for (i = 0; i < b->njobs; i++)
+  { pthread_mutex_lock(&b->lock);
+    while (i - b->taken >= b->window)
+      pthread_cond_wait(&b->changed,&b->lock);
+    pthread_mutex_unlock(&b->lock);
+    b->jobs[i].source = srcmap_open(b->jobs[i].pgm);
+    /* without memory for it, the index is built later */
+    if (b->jobs[i].source != NULL)
+      srcmap_lines(b->jobs[i].source);
+    pthread_mutex_lock(&b->lock);
+    b->read = i + 1;
+    pthread_cond_broadcast(&b->changed);
+    pthread_mutex_unlock(&b->lock);
+  }
+  return NULL;
+}
+
+/* compileJob compiles one file of a batch, with
+ * the listing going to memory
+ */
+static void compileJob(CompileJob * job)
+{ if (job->source == NULL)
+    return;
+  source = job->source;
+  listing = open_memstream(&job->text,&job->size);
+  if (listing == NULL || !compileSource(job->pgm,1))
+    job->failed = TRUE;
+  if (listing != NULL)
+    fclose(listing);
+  srcmap_close(source);
+}
+
+/* compileWorker takes jobs until none are left */
+static void * compileWorker(void * arg)
+{ Batch * b = (Batch *) arg;
+  int i;
+  while (TRUE)
+  { pthread_mutex_lock(&b->lock);
+    if (b->taken == b->njobs)
+    { pthread_mutex_unlock(&b->lock);
+      break;
     }
-  strcpy(pgm,argv[1]) ;
-  if (strchr (pgm, '.') == NULL)
-     strcat(pgm,".tny");
-  source = fopen(pgm,"r");
-  if (source==NULL)
-  { fprintf(stderr,"File %s not found\n",pgm);
-    exit(1);
+    i = b->taken++;
+    pthread_cond_broadcast(&b->changed);
+    while (b->read <= i)
+      pthread_cond_wait(&b->changed,&b->lock);
+    pthread_mutex_unlock(&b->lock);
+    compileJob(&b->jobs[i]);
+    pthread_mutex_lock(&b->lock);
+    b->jobs[i].done = TRUE;
+    pthread_cond_broadcast(&b->changed);
+    pthread_mutex_unlock(&b->lock);
+  }
+  return NULL;
+}
+
+/* compileFiles compiles every file on a pool of
+ * workers, one per processor, and writes the
+ * listings in the order given; returns the exit
+ * status
+ */
+static int compileFiles(int nfiles, char * files[])
+{ int nthreads = processors();
+  pthread_t * threads = malloc((nthreads + 1) * sizeof(pthread_t));
+  int i, started = 0, workers = 0, status = 0;
+  Batch b;
+  b.jobs = (CompileJob *) calloc(nfiles, sizeof(CompileJob));
+  if (b.jobs == NULL || threads == NULL)
+  { fprintf(stderr,"Out of memory\n");
+    return 1;
   }
-  listing = stdout; /* send listing to screen */
-  fprintf(listing,"C-MINUS COMPILATION: %s\n",pgm);
-#if NO_PARSE
-  while (getToken()!=ENDFILE);
-#else
-  syntaxTree = parse();
-  if (TraceParse) {
-    fprintf(listing,"\nSyntax tree:\n");
-    printTree(syntaxTree);
+  b.njobs = nfiles;
+  b.read = 0;
+  b.taken = 0;
+  if (nthreads > nfiles) nthreads = nfiles;
+  /* one source ready for each worker */
+  b.window = nthreads;
+  pthread_mutex_init(&b.lock,NULL);
+  pthread_cond_init(&b.changed,NULL);
+  for (i = 0; i < nfiles; i++)
+    b.jobs[i].pgm = files[i];
+  /* without a reader thread, open them all here */
+  if (pthread_create(&threads[started],NULL,readSources,&b) == 0)
+    started++;
+  else
+  { b.window = nfiles;
+    readSources(&b);
   }
-#if !NO_ANALYZE
-  if (! Error)
-  { if (TraceAnalyze) fprintf(listing,"\nBuilding Symbol Table...\n");
-    buildSymtab(syntaxTree);
+  for (i = 0; i < nthreads; i++)
+    if (pthread_create(&threads[started],NULL,compileWorker,&b) == 0)
+    { started++;
+      workers++;
+    }
+  /* without any worker, compile here */
+  if (workers == 0)
+    compileWorker(&b);
+  for (i = 0; i < nfiles; i++)
+  { CompileJob * job = &b.jobs[i];
+    pthread_mutex_lock(&b.lock);
+    while (!job->done)
+      pthread_cond_wait(&b.changed,&b.lock);
+    pthread_mutex_unlock(&b.lock);
+    /* keep the messages in order with the listings */
+    if (job->source == NULL || job->failed)
+      fflush(stdout);
+    if (job->source == NULL)
+    { fprintf(stderr,"File %s not found\n",job->pgm);
+      status = 1;
+    }
+    else if (job->failed)
+    { fprintf(stderr,"Out of memory\n");
+      status = 1;
+    }
+    else
+      fwrite(job->text,1,job->size,stdout);
+    free(job->text);
   }
-  if (! Error)
-  { if (TraceAnalyze) fprintf(listing,"\nChecking Types...\n");
-    typeCheck(syntaxTree);
-    if (TraceAnalyze) fprintf(listing,"\nType Checking Finished\n");
+  for (i = 0; i < started; i++)
+    pthread_join(threads[i],NULL);
+  pthread_mutex_destroy(&b.lock);
+  pthread_cond_destroy(&b.changed);
+  free(b.jobs);
+  free(threads);
+  return status;
+}
+
+/* addFiles appends the file names of arg to the
+ * list of files: the name itself, or for @list the
+ * names in the file list, one per line; returns
+ * FALSE if the list cannot be read
+ */
+static int addFiles(const char * arg, char *** files, int * nfiles, int * cap)
+{ FILE * list = NULL;
+  char * line = NULL;
+  size_t linecap = 0;
+  ssize_t len;
+  char * pgm;
+  int more = TRUE;
+  if (arg[0] == '@' && (list = fopen(arg+1,"r")) == NULL)
+  { fprintf(stderr,"File %s not found\n",arg+1);
+    return FALSE;
   }
-#if !NO_CODE
-  if (! Error)
-  { char * codefile;
-    int fnlen = strcspn(pgm,".");
-    codefile = (char *) calloc(fnlen+4, sizeof(char));
-    strncpy(codefile,pgm,fnlen);
-    strcat(codefile,".tm");
-    code = fopen(codefile,"w");
-    if (code == NULL)
-    { printf("Unable to open %s\n",codefile);
+  while (more)
+  { if (list == NULL)
+    { pgm = fileName(arg);
+      more = FALSE;
+    }
+    else if ((len = getline(&line,&linecap,list)) < 0)
+      break;
+    else
+    { while (len > 0 && (line[len-1] == '\n' || line[len-1] == '\r'))
+        line[--len] = '\0';
+      if (len == 0)
+        continue;
+      pgm = fileName(line);
+    }
+    if (*nfiles == *cap)
+    { char ** grown = realloc(*files, (*cap ? *cap * 2 : 16) * sizeof(char *));
+      if (grown == NULL)
+        pgm = NULL;
+      else
+      { *files = grown;
+        *cap = *cap ? *cap * 2 : 16;
+      }
+    }
+    if (pgm == NULL)
+    { fprintf(stderr,"Out of memory\n");
       exit(1);
     }
-    codeGen(syntaxTree,codefile);
-    fclose(code);
+    (*files)[(*nfiles)++] = pgm;
   }
-#endif
-#endif
-#endif
-  fclose(source);
-  return 0;
+  free(line);
+  if (list != NULL)
+    fclose(list);
+  return TRUE;
 }
 
+int main( int argc, char * argv[] )
+{ char ** files = NULL; /* source code file names */
+  int i, nfiles = 0, cap = 0, status;
+  if (argc < 2)
+    { fprintf(stderr,"usage: %s <filename>... | @<filelist> | --serve [<socket>]\n",argv[0]);
+      exit(1);
+    }
+  if (strcmp(argv[1],"--serve") == 0)
+    return serve(argc > 2 ? argv[2] : NULL);
+  for (i = 1; i < argc; i++)
+    if (!addFiles(argv[i],&files,&nfiles,&cap))
+      exit(1);
+  /* a single file is compiled here, with its
+     listing going straight to the screen */
+  if (nfiles == 1 && argv[1][0] != '@')
+  { source = srcmap_open(files[0]);
+    if (source==NULL)
+    { fprintf(stderr,"File %s not found\n",files[0]);
+      exit(1);
+    }
+    listing = stdout; /* send listing to screen */
+    if (!compileSource(files[0],
+                 CHECK_THREADS > 0 ? CHECK_THREADS : processors()))
+    { fprintf(stderr,"Out of memory\n");
+      exit(1);
+    }
+    srcmap_close(source);
+    status = 0;
+  }
+  else
+    status = compileFiles(nfiles,files);
+  for (i = 0; i < nfiles; i++)
+    free(files[i]);
+  free(files);
+  return status;
+}
@@ -0,0 +1,107 @@
+/****************************************************/
+/* File: outbuf.c                                   */
+/* Buffered writer for the listing file             */
+/****************************************************/
+
+#include <string.h>
+#include "outbuf.h"
+
+/* the buffer shared by the listing producers,
+   one per compiling thread */
+static __thread OutBuf listingBuf;
+
+/* Function out_to returns the listing buffer */
+OutBuf * out_to(FILE * file)
+{ if (listingBuf.file != file)
+  { out_flush(&listingBuf);
+    listingBuf.file = file;
+  }
+  return &listingBuf;
+}
+
+/* Procedure out_flush writes the held text out */
+void out_flush(OutBuf * out)
+{ if (out->len > 0 && out->file != NULL)
+    fwrite(out->data,1,out->len,out->file);
+  out->len = 0;
+}
+
+/* Procedure out_mem appends len bytes of s */
+void out_mem(OutBuf * out, const char * s, int len)
+{ if (out->len + len > OUTBUFSIZE)
+  { out_flush(out);
+    /* too long to hold, pass it on whole */
+    if (len > OUTBUFSIZE)
+    { fwrite(s,1,len,out->file);
+      return;
+    }
+  }
+  memcpy(out->data + out->len,s,len);
+  out->len += len;
+}
+
+/* Procedure out_char appends one character */
+void out_char(OutBuf * out, int c)
+{ if (out->len == OUTBUFSIZE)
+    out_flush(out);
+  out->data[out->len++] = c;
+}
+
+/* Procedure out_str appends a string */
+void out_str(OutBuf * out, const char * s)
+{ out_mem(out,s,strlen(s));
+}
+
+/* Procedure out_spaces appends n spaces */
+void out_spaces(OutBuf * out, int n)
+{ static const char spaces[] = "                                ";
+  for (; n > 32; n -= 32)
+    out_mem(out,spaces,32);
+  if (n > 0)
+    out_mem(out,spaces,n);
+}
+
+/* pad writes the padding of a field of len
+   characters in width columns, before it for a
+   positive width and after it for a negative one */
+static void pad(OutBuf * out, const char * s, int len, int width)
+{ int fill = (width < 0 ? -width : width) - len;
+  if (width > 0)
+    out_spaces(out,fill);
+  out_mem(out,s,len);
+  if (width < 0)
+    out_spaces(out,fill);
+}
+
+/* Procedure out_strw appends a padded string */
+void out_strw(OutBuf * out, const char * s, int width)
+{ pad(out,s,strlen(s),width);
+}
+
+/* format writes n in decimal at the end of buf and
+   returns where it starts */
+static char * format(int n, char * end)
+{ unsigned u = n < 0 ? 0u - (unsigned) n : (unsigned) n;
+  char * p = end;
+  do
+  { *--p = '0' + u % 10;
+    u /= 10;
+  } while (u > 0);
+  if (n < 0)
+    *--p = '-';
+  return p;
+}
+
+/* Procedure out_int appends a number */
+void out_int(OutBuf * out, int n)
+{ char buf[12];
+  char * p = format(n,buf + sizeof(buf));
+  out_mem(out,p,buf + sizeof(buf) - p);
+}
+
+/* Procedure out_intw appends a padded number */
+void out_intw(OutBuf * out, int n, int width)
+{ char buf[12];
+  char * p = format(n,buf + sizeof(buf));
+  pad(out,p,buf + sizeof(buf) - p,width);
+}
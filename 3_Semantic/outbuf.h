@@ -0,0 +1,65 @@
+/****************************************************/
+/* File: outbuf.h                                   */
+/* Buffered writer for the listing file             */
+/****************************************************/
+
+#ifndef _OUTBUF_H_
+#define _OUTBUF_H_
+
+#include <stdio.h>
+
+/* OUTBUFSIZE is the size of the blocks written out */
+#define OUTBUFSIZE 65536
+
+/* OutBuf collects listing text in memory and writes
+ * it to its file in blocks of OUTBUFSIZE. Numbers and
+ * padded columns are formatted by hand, the way the
+ * printf formats of the listing did: a positive width
+ * pads on the left as %4d does, a negative one on the
+ * right as %-14s does.
+ */
+typedef struct
+   { FILE * file; /* where the text goes */
+     int len; /* bytes waiting in data */
+     char data[OUTBUFSIZE];
+   } OutBuf;
+
+/* Function out_to returns the listing buffer set to
+ * write to file; text still held for another file
+ * is flushed first
+ */
+OutBuf * out_to(FILE * file);
+
+/* Procedure out_flush writes the held text out; the
+ * listing producers flush before returning, so that
+ * their output stays in order with direct fprintf
+ * calls on the same file
+ */
+void out_flush(OutBuf * out);
+
+/* Procedure out_mem appends len bytes of s */
+void out_mem(OutBuf * out, const char * s, int len);
+
+/* Procedure out_char appends one character */
+void out_char(OutBuf * out, int c);
+
+/* Procedure out_str appends a string */
+void out_str(OutBuf * out, const char * s);
+
+/* Procedure out_spaces appends n spaces */
+void out_spaces(OutBuf * out, int n);
+
+/* Procedure out_strw appends a string padded to
+ * width columns, as %<width>s
+ */
+void out_strw(OutBuf * out, const char * s, int width);
+
+/* Procedure out_int appends a number, as %d */
+void out_int(OutBuf * out, int n);
+
+/* Procedure out_intw appends a number padded to
+ * width columns, as %<width>d
+ */
+void out_intw(OutBuf * out, int n, int width);
+
+#endif
@@ -0,0 +1,202 @@
+/****************************************************/
+/* File: scan.c                                     */
+/* The scanner implementation for the C- compiler   */
+/* Table-driven version: the DFA, its character     */
+/* classes and the keyword hash are generated by    */
+/* scangen into scantab.h; cminus.l is the flex     */
+/* version of the same scanner                      */
+/****************************************************/
+
+#include "globals.h"
+#include "util.h"
+#include "scan.h"
+#include "scantab.h"
+#include "skip.h"
+
+/* lexeme of identifier or reserved word */
+__thread TokenSlice tokenSlice;
+
+/* lookup an identifier to see if it is a reserved word */
+/* uses the perfect hash generated by scangen */
+static TokenType reservedLookup (const char * str, int length)
+{ int h = KWHASH(length,str[0],str[length-1]);
+  if (keywordTable[h].len == length &&
+      !memcmp(str,keywordTable[h].str,length))
+    return keywordTable[h].tok;
+  return ID;
+}
+
+/* Function newScanner returns a scanner over src */
+Scanner * newScanner(SourceMap * src, FILE * out)
+{ Scanner * s = (Scanner *) malloc(sizeof(Scanner));
+  if (s == NULL)
+    return NULL;
+  s->source = src;
+  s->listing = out;
+  s->trace = TraceScan;
+  s->lexeme.offset = 0;
+  s->lexeme.length = 0;
+  s->pos = 0;
+  s->yyscanner = NULL;
+  return s;
+}
+
+/* Procedure freeScanner releases a scanner */
+void freeScanner(Scanner * s)
+{ free(s);
+}
+
+/* nextToken scans the next token of s into its lexeme */
+static TokenType nextToken(Scanner * s)
+{  SourceMap * src = s->source;
+   const unsigned char * text = (const unsigned char *) src->text;
+   int limit = src->size;
+   const char * end = src->text + limit;
+   const char * skipped;
+   /* position of the next character */
+   int pos = s->pos;
+   /* start of the lexeme, moved past blanks and comments */
+   int start = pos;
+   /* holds current token to be returned */
+   TokenType currentToken;
+   /* current state - always begins at START */
+   StateType state = START;
+   int cls, next;
+   while (TRUE)
+   { cls = pos < limit ? charClass[text[pos]] : CC_EOF;
+     next = transition[state][cls];
+     if (next >= ACCEPT)
+       break;
+     if (state == START)
+     { start = pos;
+       if (cls == CC_NEWLINE)
+       { /* indentation and blank lines in one step */
+         pos = skipBlanks(src->text + pos + 1, end) - src->text;
+         continue;
+       }
+     }
+     pos++;
+     state = next;
+     if (state == INCOMMENT)
+     { skipped = skipComment(src->text + pos, end);
+       if (skipped != NULL)
+       { pos = skipped - src->text;
+         state = START;
+       }
+       else
+         pos = limit;
+     }
+   }
+   if (state == START)
+     start = pos;
+   if (next >= BACKUP)
+     currentToken = tokenKind[next - BACKUP];
+   else
+   { currentToken = tokenKind[next - ACCEPT];
+     pos++;
+   }
+   if (currentToken == ENDFILE)
+     start = pos;
+   s->pos = pos;
+   s->lexeme.offset = start;
+   s->lexeme.length = pos - start;
+   if (currentToken == ID)
+     currentToken = reservedLookup(src->text + start, pos - start);
+   return currentToken;
+}
+
+/* function scanToken returns the
+ * next token of the scanner s
+ */
+TokenType scanToken(Scanner * s)
+{ TokenType currentToken = nextToken(s);
+  if (s->trace) {
+    /* end the lexeme in place for printing, as flex does */
+    char * text = s->source->text + s->lexeme.offset;
+    char held = text[s->lexeme.length];
+    text[s->lexeme.length] = '\0';
+    fprintf(s->listing,"\t%d: ",srcmap_line(s->source,s->lexeme.offset));
+    fprintToken(s->listing,currentToken,text);
+    text[s->lexeme.length] = held;
+  }
+  return currentToken;
+}
+
+/* the scanner used by getToken */
+static __thread Scanner * globalScanner = NULL;
+
+/* function getToken returns the next token
+ * of source, keeping srcpos and tokenSlice
+ */
+TokenType getToken(void)
+{ TokenType currentToken;
+  if (globalScanner == NULL)
+  { globalScanner = newScanner(source,listing);
+    if (globalScanner == NULL)
+    { fprintf(listing,"Out of memory error at line %d\n",lineOf(srcpos));
+      return ENDFILE;
+    }
+  }
+  currentToken = scanToken(globalScanner);
+  srcpos = globalScanner->lexeme.offset;
+  tokenSlice = globalScanner->lexeme;
+  return currentToken;
+}
+
+/* growStream resizes the token stream to hold cap tokens */
+static int growStream(TokenStream * ts, int cap)
+{ TokenType * kind = realloc(ts->kind, cap * sizeof(TokenType));
+  int * offset = realloc(ts->offset, cap * sizeof(int));
+  int * length = realloc(ts->length, cap * sizeof(int));
+  if (kind) ts->kind = kind;
+  if (offset) ts->offset = offset;
+  if (length) ts->length = length;
+  if (!kind || !offset || !length)
+    return FALSE;
+  ts->capacity = cap;
+  return TRUE;
+}
+
+/* Function tokenizeAll scans the whole source
+ * of s at once and returns its token stream
+ */
+TokenStream * tokenizeAll(Scanner * s)
+{ TokenStream * ts = (TokenStream *) malloc(sizeof(TokenStream));
+  TokenType currentToken;
+  if (ts == NULL)
+  { fprintf(s->listing,"Out of memory error at line %d\n",
+            srcmap_line(s->source,s->lexeme.offset));
+    return NULL;
+  }
+  ts->count = 0;
+  ts->capacity = 0;
+  ts->kind = NULL;
+  ts->offset = NULL;
+  ts->length = NULL;
+  do
+  { /* start from about one token per eight bytes of source */
+    if (ts->count == ts->capacity &&
+        !growStream(ts, ts->capacity ? ts->capacity * 2 : s->source->size / 8 + 16))
+    { fprintf(s->listing,"Out of memory error at line %d\n",
+              srcmap_line(s->source,s->lexeme.offset));
+      freeTokenStream(ts);
+      return NULL;
+    }
+    currentToken = nextToken(s);
+    ts->kind[ts->count] = currentToken;
+    ts->offset[ts->count] = s->lexeme.offset;
+    ts->length[ts->count] = s->lexeme.length;
+    ts->count++;
+  } while (currentToken != ENDFILE);
+  return ts;
+}
+
+/* Procedure freeTokenStream releases a token stream */
+void freeTokenStream(TokenStream * ts)
+{ if (ts == NULL)
+    return;
+  free(ts->kind);
+  free(ts->offset);
+  free(ts->length);
+  free(ts);
+}
@@ -8,16 +8,66 @@
 #ifndef _SCAN_H_
 #define _SCAN_H_
 
-/* MAXTOKENLEN is the maximum size of a token */
+/* MAXTOKENLEN is the maximum size of a traced lexeme */
 #define MAXTOKENLEN 40
 
-extern int current;
-/* tokenString array stores the lexeme of each token */
-extern char tokenString[2][MAXTOKENLEN+1];
+/* tokenSlice locates the lexeme of the last token
+ * inside the source map; lexemes are not copied
+ */
+extern __thread TokenSlice tokenSlice;
+
+/* TokenStream holds every token of the source
+ * in struct-of-arrays form, ending with ENDFILE
+ */
+typedef struct
+   { int count;
+     int capacity;
+     TokenType * kind;
+     int * offset; /* start of the lexeme in the source map */
+     int * length; /* length of the lexeme */
+   } TokenStream;
+
+/* Scanner holds all the state of one scan, so that
+ * several sources can be scanned at the same time,
+ * each by its own thread; only getToken uses the
+ * globals source, listing, srcpos and tokenSlice.
+ * Tokens carry byte offsets only; their lines are
+ * looked up in the line index of the source map.
+ */
+typedef struct
+   { SourceMap * source; /* text being scanned */
+     FILE * listing; /* receives the trace */
+     int trace; /* print each token, as TraceScan */
+     TokenSlice lexeme; /* lexeme of the last token */
+     int pos; /* next character (scan.c) */
+     void * yyscanner; /* reentrant flex state (cminus.l) */
+   } Scanner;
+
+/* Function newScanner returns a scanner over src
+ * writing to out, with trace taken from TraceScan;
+ * NULL if out of memory
+ */
+Scanner * newScanner(SourceMap * src, FILE * out);
+
+/* Function scanToken returns the next token
+ * of the scanner s
+ */
+TokenType scanToken(Scanner * s);
+
+/* Procedure freeScanner releases a scanner */
+void freeScanner(Scanner * s);
 
 /* function getToken returns the 
  * next token in source file
  */
 TokenType getToken(void);
 
+/* Function tokenizeAll scans the whole source
+ * of s at once and returns its token stream
+ */
+TokenStream * tokenizeAll(Scanner * s);
+
+/* Procedure freeTokenStream releases a token stream */
+void freeTokenStream(TokenStream *);
+
 #endif
@@ -0,0 +1,193 @@
+/****************************************************/
+/* File: serve.c                                    */
+/* Compile server for the C- compiler               */
+/* A request is the line                            */
+/*   compile <size> <name>                          */
+/* followed by the size bytes of the source. The    */
+/* answer is the line                               */
+/*   result <error> <nerrors> <size>                */
+/* then a line per error                            */
+/*   <line> <column> <message>\t<name>              */
+/* with column 0 for an error that is not a syntax  */
+/* error, see SourceError;                          */
+/* then the size bytes of the listing, which holds  */
+/* the symbol tables. A request that cannot be read */
+/* is answered by the line fail <reason> and ends   */
+/* the session                                      */
+/****************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "libcminus.h"
+#include "serve.h"
+
+/* MAXCLIENTS bounds the connections served at once;
+ * the others wait in the backlog of the socket
+ */
+#define MAXCLIENTS 64
+
+/* BACKOFF is how long, in microseconds, the server
+ * waits when it runs out of descriptors or memory
+ * for a connection
+ */
+#define BACKOFF 100000
+
+/* the connections being served */
+static int clients = 0;
+static pthread_mutex_t clientLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t clientLeft = PTHREAD_COND_INITIALIZER;
+
+/* session answers the requests read from in until
+ * its end, on the warm compilation of the thread;
+ * returns FALSE if a request could not be read
+ */
+static int session(FILE * in, FILE * out)
+{ CmResult * r = NULL;
+  char * line = NULL;
+  size_t linecap = 0;
+  ssize_t len;
+  char * text = NULL;
+  size_t textcap = 0;
+  unsigned long size;
+  const char * reason = NULL;
+  int i, n;
+  while (reason == NULL && (len = getline(&line,&linecap,in)) >= 0)
+  { CmResult * done;
+    while (len > 0 && (line[len-1] == '\n' || line[len-1] == '\r'))
+      line[--len] = '\0';
+    n = -1;
+    if (sscanf(line,"compile %lu %n",&size,&n) < 1 || n < 0)
+    { reason = "bad request";
+      break;
+    }
+    if (size > INT_MAX)
+    { reason = "source too large";
+      break;
+    }
+    if (size + 1 > textcap)
+    { char * grown = (char *) realloc(text, size + 1);
+      if (grown == NULL)
+      { reason = "out of memory";
+        break;
+      }
+      text = grown;
+      textcap = size + 1;
+    }
+    if (fread(text,1,size,in) != size)
+    { reason = "short source";
+      break;
+    }
+    done = cm_recompile(r,line + n,text,size);
+    if (done == NULL)
+    { reason = "out of memory";
+      break;
+    }
+    r = done;
+    fprintf(out,"result %d %d %lu\n",r->error,r->nerrors,
+            (unsigned long) r->listingSize);
+    for (i = 0; i < r->nerrors; i++)
+      fprintf(out,"%d %d %s\t%s\n",r->errors[i].line,
+              r->errors[i].column,r->errors[i].message,
+              r->errors[i].name != NULL ? r->errors[i].name : "");
+    fwrite(r->listing,1,r->listingSize,out);
+    if (fflush(out) != 0)
+      break;
+  }
+  if (reason != NULL)
+  { fprintf(out,"fail %s\n",reason);
+    fflush(out);
+  }
+  cm_free(r);
+  free(text);
+  free(line);
+  return reason == NULL;
+}
+
+/* client runs the session of a connection */
+static void * client(void * arg)
+{ int fd = (int) (long) arg;
+  int fd2 = dup(fd);
+  FILE * in = fdopen(fd,"r");
+  FILE * out = fd2 < 0 ? NULL : fdopen(fd2,"w");
+  if (in != NULL && out != NULL)
+    session(in,out);
+  if (in != NULL) fclose(in); else close(fd);
+  if (out != NULL) fclose(out); else if (fd2 >= 0) close(fd2);
+  pthread_mutex_lock(&clientLock);
+  clients--;
+  pthread_cond_signal(&clientLeft);
+  pthread_mutex_unlock(&clientLock);
+  return NULL;
+}
+
+/* Function serve answers compile requests */
+int serve(const char * path)
+{ struct sockaddr_un addr;
+  struct stat st;
+  int fd;
+  /* a client going away must not end the server */
+  signal(SIGPIPE,SIG_IGN);
+  if (path == NULL)
+    return session(stdin,stdout) ? 0 : 1;
+  if (strlen(path) >= sizeof(addr.sun_path))
+  { fprintf(stderr,"Socket name %s too long\n",path);
+    return 1;
+  }
+  memset(&addr,0,sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path,path);
+  /* replace the socket of a server gone before */
+  if (stat(path,&st) == 0 && S_ISSOCK(st.st_mode))
+    unlink(path);
+  fd = socket(AF_UNIX,SOCK_STREAM,0);
+  if (fd < 0 || bind(fd,(struct sockaddr *) &addr,sizeof(addr)) < 0 ||
+      listen(fd,SOMAXCONN) < 0)
+  { perror(path);
+    if (fd >= 0)
+      close(fd);
+    return 1;
+  }
+  for (;;)
+  { pthread_t thread;
+    int conn;
+    pthread_mutex_lock(&clientLock);
+    while (clients >= MAXCLIENTS)
+      pthread_cond_wait(&clientLeft,&clientLock);
+    pthread_mutex_unlock(&clientLock);
+    conn = accept(fd,NULL,NULL);
+    if (conn < 0)
+    { if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      /* wait for the sessions to give some back */
+      if (errno == EMFILE || errno == ENFILE ||
+          errno == ENOBUFS || errno == ENOMEM)
+      { usleep(BACKOFF);
+        continue;
+      }
+      perror(path);
+      close(fd);
+      return 1;
+    }
+    pthread_mutex_lock(&clientLock);
+    clients++;
+    pthread_mutex_unlock(&clientLock);
+    if (pthread_create(&thread,NULL,client,(void *) (long) conn) != 0)
+    { pthread_mutex_lock(&clientLock);
+      clients--;
+      pthread_mutex_unlock(&clientLock);
+      close(conn);
+      usleep(BACKOFF);
+      continue;
+    }
+    pthread_detach(thread);
+  }
+}
@@ -0,0 +1,19 @@
+/****************************************************/
+/* File: serve.h                                    */
+/* Compile server for the C- compiler               */
+/* cminus --serve answers compile requests on the   */
+/* standard input and output or on a Unix domain    */
+/* socket, keeping its memory warm between them     */
+/****************************************************/
+
+#ifndef _SERVE_H_
+#define _SERVE_H_
+
+/* Function serve answers the requests of the clients
+ * of the Unix domain socket at path, each on a thread
+ * of its own, or those of the standard input if path
+ * is NULL; returns the exit status of cminus
+ */
+int serve(const char * path);
+
+#endif
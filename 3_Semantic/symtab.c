@@ -13,28 +13,47 @@
 #include <string.h>
 #include "symtab.h"
 #include "util.h"
+#include "outbuf.h"
 
 /* SHIFT is the power of two used as multiplier
    in hash function  */
 #define SHIFT 4
 
-/* the hash function */
+/* SCOPESLOTS is the size of the first table of a scope */
+#define SCOPESLOTS 4
+
+/* the bucket of the former chained tables, which still
+   orders the listing; over an interned name, whose
+   bucket is kept in the name, so each name is only
+   hashed once */
 static int hash ( char * key )
-{ int temp = 0;
+{ NameRec * rec = NAMEREC(key);
+  int temp = 0;
   int i = 0;
+  if (rec->bucket >= 0)
+    return rec->bucket;
   while (key[i] != '\0')
   { temp = ((temp << SHIFT) + key[i]) % HASHSIZE;
     ++i;
   }
+  rec->bucket = temp;
   return temp;
 }
 
-static FunctionInfo * fninfo_init ()
+/* Function info with room for numparam parameters,
+ * or NULL if out of memory. */
+static FunctionInfo * fninfo_init ( int numparam )
 { int i;
-  FunctionInfo * fninfo = (FunctionInfo * )malloc(sizeof(FunctionInfo));
+  FunctionInfo * fninfo = (FunctionInfo * )arena_alloc(arena,sizeof(FunctionInfo));
+  if (fninfo == NULL)
+    return NULL;
   fninfo->retn = Void;
-  fninfo->numparam = 0;
-  for (i = 0; i < MAXPARAM; ++i)
+  fninfo->numparam = numparam;
+  fninfo->params = numparam == 0 ? NULL :
+    (ParamInfo *)arena_alloc(arena,numparam * sizeof(ParamInfo));
+  if (numparam > 0 && fninfo->params == NULL)
+    return NULL;
+  for (i = 0; i < numparam; ++i)
   { fninfo->params[i].type = Void;
     fninfo->params[i].name = NULL;
   }
@@ -42,97 +61,194 @@ static FunctionInfo * fninfo_init ()
 }
 
 /* global scope */
-static ScopeList globalScope = NULL;
+static __thread ScopeList globalScope = NULL;
 
 ScopeList scope_init ( char * name )
-{ int i;
-  ScopeList scope = (ScopeList)malloc(sizeof(struct ScopeListRec));
-  scope->name = copyString(name);
-  for (i = 0; i < HASHSIZE; ++i)
-    scope->bucket[i] = NULL;
+{ ScopeList scope = (ScopeList)arena_alloc(arena,sizeof(struct ScopeListRec));
+  if (scope == NULL)
+    return NULL;
+  scope->name = name;
+  scope->lineno = 0;
+  scope->num = 0;
+  scope->depth = 0;
+  scope->slots = NULL;
+  scope->size = 0;
+  scope->count = 0;
+  scope->symbols = NULL;
   scope->parent = NULL;
   scope->child = NULL;
+  scope->last = NULL;
   scope->next = NULL;
   return scope;
 }
 
-/* Initialize global scope. */
+/* The global scope as global_keep built it: the
+ * record, its table and the predefined functions,
+ * which the analysis of a program changes.
+ */
+static __thread int globalKept = FALSE;
+static __thread struct ScopeListRec globalCopy;
+static __thread BucketList globalSlots[SCOPESLOTS];
+static __thread BucketList builtin[2];
+static __thread struct BucketListRec builtinCopy[2];
+
+/* Initialize global scope; -1 if out of memory. */
 int global_init ( void )
 { BucketList input, output;
-  globalScope = scope_init("global");
+  if (globalKept)
+  { *globalScope = globalCopy;
+    memcpy(globalScope->slots, globalSlots, sizeof(globalSlots));
+    *builtin[0] = builtinCopy[0];
+    *builtin[1] = builtinCopy[1];
+    return 2;
+  }
+  globalScope = scope_init(internString("global"));
+  if (globalScope == NULL)
+    return -1;
   // predefined, method input
-  input = st_insert(global_scope(), "input", Function, 0, 0, 0);
-  input->fninfo = fninfo_init();
+  input = st_insert(global_scope(), internString("input"), Function, 0, 0, 0);
+  if (input == NULL || (input->fninfo = fninfo_init(0)) == NULL)
+    return -1;
   input->fninfo->retn = Integer;
   // predefined, method output
-  output = st_insert(global_scope(), "output", Function, 0, 0, 1);
-  output->fninfo = fninfo_init();
+  output = st_insert(global_scope(), internString("output"), Function, 0, 0, 1);
+  if (output == NULL || (output->fninfo = fninfo_init(1)) == NULL)
+    return -1;
   output->fninfo->retn = Void;
-  output->fninfo->numparam = 1;
   output->fninfo->params[0].type = Integer;
   output->fninfo->params[0].name = "";
   return 2;
 }
 
+/* Build the global scope and keep it. */
+int global_keep ( void )
+{ globalKept = FALSE;
+  if (global_init() < 0)
+    return FALSE;
+  globalCopy = *globalScope;
+  // two symbols fit the first table
+  memcpy(globalSlots, globalScope->slots, sizeof(globalSlots));
+  builtin[0] = globalScope->symbols->next;
+  builtin[1] = globalScope->symbols;
+  builtinCopy[0] = *builtin[0];
+  builtinCopy[1] = *builtin[1];
+  globalKept = TRUE;
+  return TRUE;
+}
+
+/* Build the global scope again from now on. */
+void global_drop ( void )
+{ globalKept = FALSE;
+}
+
 /* Get global scope. */
 ScopeList global_scope( void )
 { return globalScope;
 }
 
-/* Traverse scope to find the given scope name, BFS. */
-ScopeList scope_find_recur ( ScopeList scope, char * name )
-{ if (!strcmp(scope->name, name))
-    return scope;
-  ScopeList retn;
-  // if in siblings, breadth-first
-  if (scope->next != NULL &&
-      (retn = scope_find_recur(scope->next, name)) != NULL)
-    return retn;
-  // if in children
-  if (scope->child != NULL &&
-      (retn = scope_find_recur(scope->child, name)) != NULL)
-    return retn;
-  // if not found
-  return NULL;
-} 
-
-/* Find scope, return proper pointer if found or NULL. */
-ScopeList scope_find ( char * scope )
-{ return scope_find_recur(globalScope, scope);
+/* The first children of the scopes still to visit
+ * by scope_find and scope_traverse, which keep them
+ * here instead of on the call stack.
+ */
+typedef struct
+   { ScopeList * items;
+     int count;
+     int capacity;
+   } ScopeStack;
+
+/* Push scope to stack; FALSE if out of memory. */
+static int scope_push ( ScopeStack * stack, ScopeList scope )
+{ if (stack->count == stack->capacity)
+  { int cap = stack->capacity ? stack->capacity * 2 : 64;
+    ScopeList * items = realloc(stack->items, cap * sizeof(ScopeList));
+    if (items == NULL)
+    { fprintf(listing,"Out of memory error in traversal\n");
+      Error = TRUE;
+      return FALSE;
+    }
+    stack->items = items;
+    stack->capacity = cap;
+  }
+  stack->items[stack->count++] = scope;
+  return TRUE;
 }
 
-/* Find variable bucket from specified scope. */
-BucketList scope_search ( ScopeList record, char * name )
-{ int h = hash(name);
-  BucketList l =  record->bucket[h];
-  while ((l != NULL) && (strcmp(name,l->name) != 0))
-    l = l->next;
-  return l;
+/* Find scope, return proper pointer if found or NULL.
+ * Siblings come first, then the children of the last
+ * sibling back to those of the first.
+ * Only for printing and debugging: the analyzer keeps
+ * the scopes it is in.
+ */
+ScopeList scope_find ( char * name )
+{ ScopeStack todo = { NULL, 0, 0 };
+  ScopeList scope = globalScope;
+  while (TRUE)
+  { for (; scope != NULL && scope->name != name; scope = scope->next)
+      if (scope->child != NULL)
+        scope_push(&todo, scope->child);
+    if (scope != NULL || todo.count == 0)
+      break;
+    scope = todo.items[--todo.count];
+  }
+  free(todo.items);
+  return scope;
 }
 
-/* Insert new scope to specified parent. */
-int scope_insert ( char * parent, char * name )
-{ ScopeList newscope, siblings;
-  // find scope
-  ScopeList parentscope = scope_find(parent);
-  if (parentscope == NULL)
-    return 0;
+/* Slot of name in the table of scope: the slot that
+ * holds it, or the empty slot where it would go.
+ * Probing starts from the hash kept in the interned
+ * name and compares names by pointer.
+ */
+static BucketList * scope_slot ( ScopeList scope, char * name )
+{ int mask = scope->size - 1;
+  int i = NAMEREC(name)->hash & mask;
+  while (scope->slots[i] != NULL && scope->slots[i]->name != name)
+    i = (i + 1) & mask;
+  return &scope->slots[i];
+}
 
-  newscope = scope_init(name);
-  newscope->parent = parentscope;
-  // check child is null
-  if (parentscope->child == NULL)
-  { parentscope->child = newscope;
-    return 1;
-  }
-  // insert to last siblings of child
-  siblings = parentscope->child;
-  while (siblings->next != NULL)
-    siblings = siblings->next;
-  siblings->next = newscope;
+/* Double the table of scope, or make its first one;
+ * returns 0 if out of memory.
+ */
+static int scope_grow ( ScopeList scope )
+{ int i, oldsize = scope->size;
+  int size = oldsize ? oldsize * 2 : SCOPESLOTS;
+  BucketList * old = scope->slots;
+  BucketList * slots = (BucketList *)arena_alloc(arena,size * sizeof(BucketList));
+  if (slots == NULL)
+    return 0;
+  for (i = 0; i < size; ++i)
+    slots[i] = NULL;
+  scope->slots = slots;
+  scope->size = size;
+  for (i = 0; i < oldsize; ++i)
+    if (old[i] != NULL)
+      *scope_slot(scope, old[i]->name) = old[i];
   return 1;
 }
 
+/* Find variable bucket from specified scope. */
+BucketList scope_search ( ScopeList record, char * name )
+{ if (record->count == 0)
+    return NULL;
+  return *scope_slot(record, name);
+}
+
+/* Insert new scope as the last child of parent. */
+ScopeList scope_insert ( ScopeList parent, char * name )
+{ ScopeList newscope = scope_init(name);
+  if (newscope == NULL)
+    return NULL;
+  newscope->parent = parent;
+  newscope->depth = parent->depth + 1;
+  if (parent->child == NULL)
+    parent->child = newscope;
+  else
+    parent->last->next = newscope;
+  parent->last = newscope;
+  return newscope;
+}
+
 static SymAddr symaddr(ScopeList scope, BucketList bucket)
 { SymAddr addr;
   addr.scope = scope;
@@ -143,12 +259,8 @@ static SymAddr symaddr(ScopeList scope, BucketList bucket)
 /* Function st_lookup returns the memory 
  * location of a variable or -1 if not found
  */
-SymAddr st_lookup ( char * scope, char * name )
-{ // find scope
-  ScopeList scopeRec = scope_find(scope);
-  if (scopeRec == NULL)
-    return symaddr(scopeRec, NULL);
-  // find variable
+SymAddr st_lookup ( ScopeList scopeRec, char * name )
+{ // find variable
   BucketList l;
   while ((l = scope_search(scopeRec, name)) == NULL && scopeRec->parent != NULL)
     scopeRec = scopeRec->parent;
@@ -156,12 +268,8 @@ SymAddr st_lookup ( char * scope, char * name )
 }
 
 /* Find ID bucket from specified scope, excluding its parent. */
-SymAddr st_lookup_excluding_parent ( char * scope, char * name )
-{ // find scope
-  ScopeList scopeRec = scope_find(scope);
-  if (scopeRec == NULL)
-    return symaddr(NULL, NULL);
-  // find variable
+SymAddr st_lookup_excluding_parent ( ScopeList scopeRec, char * name )
+{ // find variable
   return symaddr(scopeRec, scope_search(scopeRec, name));
 }
 
@@ -169,96 +277,201 @@ SymAddr st_lookup_excluding_parent ( char * scope, char * name )
  * memory locations into the symbol table.
  */
 BucketList st_insert ( ScopeList scope, char * name, ExpType type, int size, int lineno, int loc )
-{ // find hashtable bucket
-  int h = hash(name);
-  BucketList l = scope->bucket[h];
-  while ((l != NULL) && (strcmp(name,l->name) != 0))
-    l = l->next;
-  if (l != NULL)
+{ BucketList l;
+  // keep the table at most three quarters full
+  if (4 * (scope->count + 1) > 3 * scope->size && !scope_grow(scope))
+    return NULL;
+  if (scope->count > 0 && *scope_slot(scope, name) != NULL)
+    return NULL;
+  l = (BucketList) arena_alloc(arena,sizeof(struct BucketListRec));
+  if (l == NULL)
     return NULL;
-  l = (BucketList) malloc(sizeof(struct BucketListRec));
-  l->name = copyString(name);
+  l->name = name;
   l->type = type;
   l->size = size;
-  l->lines = (LineList) malloc(sizeof(struct LineListRec));
-  l->lines->lineno = lineno;
+  l->lines.bytes = NULL;
+  l->lines.length = 0;
+  l->lines.capacity = 0;
+  l->lines.count = 0;
+  l->lines.last = 0;
+  st_appendline(l, lineno);
   l->memloc = loc;
   l->fninfo = NULL;
-  l->lines->next = NULL;
-  l->next = scope->bucket[h];
-  scope->bucket[h] = l;
+  *scope_slot(scope, name) = l;
+  scope->count++;
+  l->next = scope->symbols;
+  scope->symbols = l;
   return l;
 } /* st_insert */
 
-/* Append lineno to bucket. */
+/* LINEBYTES is the first capacity of a line list */
+#define LINEBYTES 8
+
+/* Append lineno to bucket. The difference from the
+ * last line number is zigzag-coded, so that a small
+ * step back stays small, and written 7 bits a byte,
+ * low bits first, with the high bit set on every
+ * byte but the last.
+ */
 void st_appendline ( BucketList bucket, int lineno )
-{ LineList t = bucket->lines;
-  while (t->next != NULL) t = t->next;
-  t->next = (LineList) malloc(sizeof(struct LineListRec));
-  t->next->lineno = lineno;
-  t->next->next = NULL;
+{ LineList * t = &bucket->lines;
+  unsigned d = (unsigned) (lineno - t->last);
+  d = (d << 1) ^ (unsigned) -(int) (d >> 31);
+  if (t->length + 5 > t->capacity)
+  { int cap = t->capacity ? t->capacity * 2 : LINEBYTES;
+    unsigned char * bytes = (unsigned char *) arena_alloc(arena,cap);
+    if (bytes == NULL)
+      return;
+    if (t->length > 0)
+      memcpy(bytes, t->bytes, t->length);
+    t->bytes = bytes;
+    t->capacity = cap;
+  }
+  while (d >= 128)
+  { t->bytes[t->length++] = (unsigned char) (d | 128);
+    d >>= 7;
+  }
+  t->bytes[t->length++] = (unsigned char) d;
+  t->last = lineno;
+  t->count++;
 }
 
-void st_appendfn ( BucketList bucket, TreeNode * node )
-{ int i;
-  FunctionInfo * fninfo = fninfo_init();
+/* Start a cursor at the first line number of bucket. */
+void st_firstline ( BucketList bucket, LineCursor * c )
+{ c->next = bucket->lines.bytes;
+  c->end = bucket->lines.bytes + bucket->lines.length;
+  c->lineno = 0;
+}
+
+/* Move a cursor to the next line number, 0 at the end. */
+int st_nextline ( LineCursor * c )
+{ unsigned d = 0;
+  int shift = 0;
+  if (c->next == c->end)
+    return 0;
+  while (*c->next & 128)
+  { d |= (unsigned) (*c->next++ & 127) << shift;
+    shift += 7;
+  }
+  d |= (unsigned) *c->next++ << shift;
+  c->lineno += (int) (d >> 1) ^ -(int) (d & 1);
+  return 1;
+}
+
+int st_appendfn ( BucketList bucket, TreeNode node )
+{ int i, n = 0;
+  TreeNode param = CHILD(node,0);
+  FunctionInfo * fninfo;
+  // count parameters; a single void one means none
+  if (TYPE(param) != Void)
+    for (; param != NULLNODE; param = SIBLING(param))
+      n++;
+  fninfo = fninfo_init(n);
   bucket->fninfo = fninfo;
-  fninfo->retn = node->type;
+  if (fninfo == NULL)
+    return FALSE;
+  fninfo->retn = TYPE(node);
   // read parameters;
-  node = node->child[0];
-  if (node->type == Void)
+  node = CHILD(node,0);
+  for (i = 0; i < n; ++i)
+  { fninfo->params[i].type = TYPE(node);
+    fninfo->params[i].name = ATTR(node).name;
+    node = SIBLING(node);
+  }
+  return TRUE;
+}
+
+/* Sort the symbols of scope into the order of the
+ * listing: by bucket of hash, newest first within a
+ * bucket, as the former chained tables kept them.
+ * Sorting a sorted list leaves it as it is.
+ */
+static void scope_sort ( ScopeList scope )
+{ BucketList head[HASHSIZE];
+  BucketList * tail[HASHSIZE];
+  BucketList l, next, * end = &scope->symbols;
+  int i;
+  if (scope->count < 2)
     return;
-  for (i = 0; i < MAXPARAM; ++i)
-  { if (node == NULL)
-      break;
-    fninfo->numparam++;
-    fninfo->params[i].type = node->type;
-    fninfo->params[i].name = copyString(node->attr.name);
-    node = node->sibling;
+  for (i = 0; i < HASHSIZE; ++i)
+    tail[i] = &head[i];
+  for (l = scope->symbols; l != NULL; l = next)
+  { next = l->next;
+    i = hash(l->name);
+    *tail[i] = l;
+    tail[i] = &l->next;
   }
+  for (i = 0; i < HASHSIZE; ++i)
+    if (tail[i] != &head[i])
+    { *end = head[i];
+      end = tail[i];
+    }
+  *end = NULL;
+}
+
+/* SCOPENAME is the size of the name of a block scope */
+#define SCOPENAME 32
+
+/* Name of scope for the listing; a block is named
+ * annon_<line>_<number> here, when printed.
+ */
+static char * scope_name ( ScopeList scope, char * buf )
+{ if (scope->name != NULL)
+    return scope->name;
+  snprintf(buf, SCOPENAME, "annon_%d_%d", scope->lineno, scope->num);
+  return buf;
 }
 
-static int scope_level;
-/* Traverse scope with given callback. */ 
+/* Traverse scope with given callback, in the order
+ * of scope_find.
+ */
 static void scope_traverse ( ScopeList scope, void (* callback) (ScopeList) )
-{ callback(scope);
-  // if in siblings, breadth-first
-  if (scope->next != NULL)
-    scope_traverse(scope->next, callback);
-  // if in children
-  if (scope->child != NULL)
-  { scope_level += 1;
-    scope_traverse(scope->child, callback);
+{ ScopeStack todo = { NULL, 0, 0 };
+  while (TRUE)
+  { // siblings, breadth-first
+    for (; scope != NULL; scope = scope->next)
+    { callback(scope);
+      if (scope->child != NULL)
+        scope_push(&todo, scope->child);
+    }
+    // then children
+    if (todo.count == 0)
+      break;
+    scope = todo.items[--todo.count];
   }
+  free(todo.items);
 }
 
 /* Print symbol table of given scope. */
-static void scope_print ( ScopeList list, FILE * listing )
-{ int i;
+static void scope_print ( ScopeList list, OutBuf * out )
+{ char name[SCOPENAME];
+  BucketList l;
   if (list == NULL)
     return;
-  for (i = 0; i < HASHSIZE; ++i)
-  { if (list->bucket[i] != NULL)
-    { BucketList l = list->bucket[i];
-      while (l != NULL)
-      { LineList t = l->lines;
-        fprintf(listing, "%-14s ",l->name);
-        fprintf(listing, "%-13s  ", dbgExpType(l->type));
-        fprintf(listing, "%-10s  ", list->name);
-        fprintf(listing, "%-8d  ",l->memloc);
-        while (t != NULL)
-        { fprintf(listing,"%4d ",t->lineno);
-          t = t->next;
-        }
-        fprintf(listing,"\n");
-        l = l->next;
-      }
+  scope_sort(list);
+  l = list->symbols;
+  while (l != NULL)
+  { LineCursor t;
+    out_strw(out,l->name,-14);
+    out_char(out,' ');
+    out_strw(out,dbgExpType(l->type),-13);
+    out_str(out,"  ");
+    out_strw(out,scope_name(list,name),-10);
+    out_str(out,"  ");
+    out_intw(out,l->memloc,-8);
+    out_str(out,"  ");
+    st_firstline(l, &t);
+    while (st_nextline(&t))
+    { out_intw(out,t.lineno,4);
+      out_char(out,' ');
     }
+    out_char(out,'\n');
+    l = l->next;
   }
 }
 
-/* File stream for writing symbol table */
-static FILE * stream;
+/* Buffer for writing symbol table */
+static __thread OutBuf * stream;
 /* Print symbol table of given scope,
  * assume `stream` as parameter implicitly.
  */
@@ -271,43 +484,49 @@ static void scope_print_stream(ScopeList list)
  * to the listing file
  */
 void printSymTab ( FILE * listing )
-{ fprintf(listing,"Variable Name Variable Type  Scope Name  Location  Line Numbers\n");
-  fprintf(listing,"------------- -------------  ----------  --------  ------------\n");
-  // implicit parameter setting
-  stream = listing;
+{ // implicit parameter setting
+  stream = out_to(listing);
+  out_str(stream,"Variable Name Variable Type  Scope Name  Location  Line Numbers\n");
+  out_str(stream,"------------- -------------  ----------  --------  ------------\n");
   scope_traverse(globalScope, scope_print_stream);
+  out_flush(stream);
 } /* printSymTab */
 
 /* Print function table of given scope. */
-static void fn_print ( ScopeList list, FILE * listing )
-{ int i, j;
+static void fn_print ( ScopeList list, OutBuf * out )
+{ char name[SCOPENAME];
+  int j;
+  BucketList l;
   if (list == NULL)
     return;
-  for (i = 0; i < HASHSIZE; ++i)
-  { if (list->bucket[i] != NULL)
-    { BucketList l = list->bucket[i];
-      while (l != NULL)
-      { if (l->type != Function)
-        { l = l->next;
-          continue;
-        }
-        LineList t = l->lines;
-        fprintf(listing, "%-13s  ",l->name);
-        fprintf(listing, "%-10s  ", list->name);
-        fprintf(listing, "%-11s  ", dbgExpType(l->fninfo->retn));
-        if (l->fninfo->numparam == 0)
-          fprintf(listing, "                %-14s", dbgExpType(Void));
-        else
-        { for (j = 0; j < l->fninfo->numparam; ++j)
-          { fprintf(listing, "\n%-40s%-14s  ",
-              " ", l->fninfo->params[j].name);
-            fprintf(listing, "%-14s", dbgExpType(l->fninfo->params[j].type));
-          }
-        }
-        fprintf(listing,"\n");
-        l = l->next;
+  scope_sort(list);
+  l = list->symbols;
+  while (l != NULL)
+  { if (l->type != Function)
+    { l = l->next;
+      continue;
+    }
+    out_strw(out,l->name,-13);
+    out_str(out,"  ");
+    out_strw(out,scope_name(list,name),-10);
+    out_str(out,"  ");
+    out_strw(out,dbgExpType(l->fninfo->retn),-11);
+    out_str(out,"  ");
+    if (l->fninfo->numparam == 0)
+    { out_spaces(out,16);
+      out_strw(out,dbgExpType(Void),-14);
+    }
+    else
+    { for (j = 0; j < l->fninfo->numparam; ++j)
+      { out_char(out,'\n');
+        out_spaces(out,40);
+        out_strw(out,l->fninfo->params[j].name,-14);
+        out_str(out,"  ");
+        out_strw(out,dbgExpType(l->fninfo->params[j].type),-14);
       }
     }
+    out_char(out,'\n');
+    l = l->next;
   }
 }
 
@@ -320,37 +539,37 @@ static void fn_print_stream(ScopeList list)
 
 /* print function table */
 void printFnTab ( FILE * listing )
-{ fprintf(listing,"Function Name  Scope Name  Return Type  Parameter Name  Parameter Type\n");
-  fprintf(listing,"-------------  ----------  -----------  --------------  --------------\n");
-  // implicit parameter setting
-  stream = listing;
+{ // implicit parameter setting
+  stream = out_to(listing);
+  out_str(stream,"Function Name  Scope Name  Return Type  Parameter Name  Parameter Type\n");
+  out_str(stream,"-------------  ----------  -----------  --------------  --------------\n");
   scope_traverse(globalScope, fn_print_stream);
+  out_flush(stream);
 }
 
 /* Print function and globals of given scope. */
-static void fn_and_global_print ( ScopeList list, FILE * listing )
-{ int i, j;
+static void fn_and_global_print ( ScopeList list, OutBuf * out )
+{ int j;
+  BucketList l;
   if (list == NULL)
     return;
-  for (i = 0; i < HASHSIZE; ++i)
-  { if (list->bucket[i] != NULL)
-    { BucketList l = list->bucket[i];
-      while (l != NULL)
-      { if (l->type != Function)
-        { l = l->next;
-          continue;
-        }
-        LineList t = l->lines;
-        fprintf(listing, "%-11s  ",l->name);
-        fprintf(listing, "%-9s  ", dbgExpType(l->type));
-        if (l->type == Function)
-          fprintf(listing, "%-11s", dbgExpType(l->fninfo->retn));
-        else
-          fprintf(listing, "%-11s", dbgExpType(l->type));
-        fprintf(listing,"\n");
-        l = l->next;
-      }
+  scope_sort(list);
+  l = list->symbols;
+  while (l != NULL)
+  { if (l->type != Function)
+    { l = l->next;
+      continue;
     }
+    out_strw(out,l->name,-11);
+    out_str(out,"  ");
+    out_strw(out,dbgExpType(l->type),-9);
+    out_str(out,"  ");
+    if (l->type == Function)
+      out_strw(out,dbgExpType(l->fninfo->retn),-11);
+    else
+      out_strw(out,dbgExpType(l->type),-11);
+    out_char(out,'\n');
+    l = l->next;
   }
 }
 
@@ -363,35 +582,37 @@ static void fn_and_global_print_stream(ScopeList list)
 
 /* print function and globals */
 void printFnAndGlobalTab ( FILE * listing )
-{ fprintf(listing,"  ID Name     ID Type    Data Type \n");
-  fprintf(listing,"-----------  ---------  -----------\n");
-  // implicit parameter setting
-  stream = listing;
+{ // implicit parameter setting
+  stream = out_to(listing);
+  out_str(stream,"  ID Name     ID Type    Data Type \n");
+  out_str(stream,"-----------  ---------  -----------\n");
   scope_traverse(globalScope, fn_and_global_print_stream);
+  out_flush(stream);
 }
 
 /* Print function parameters and local variables of given scope. */
-static void fnparam_and_local_print ( ScopeList list, FILE * listing )
-{ int i, j;
+static void fnparam_and_local_print ( ScopeList list, OutBuf * out )
+{ char name[SCOPENAME];
+  int j;
+  BucketList l;
   if (list == NULL)
     return;
-  for (i = 0; i < HASHSIZE; ++i)
-  { if (list->bucket[i] != NULL)
-    { BucketList l = list->bucket[i];
-      while (l != NULL)
-      { if (l->type == Function)
-        { l = l->next;
-          continue;
-        }
-        LineList t = l->lines;
-        fprintf(listing, "%-10s  ",list->name);
-        fprintf(listing, "%-12d  ", scope_level);
-        fprintf(listing, "%-7s  ", l->name);
-        fprintf(listing, "%s", dbgExpType(l->type));
-        fprintf(listing,"\n");
-        l = l->next;
-      }
+  scope_sort(list);
+  l = list->symbols;
+  while (l != NULL)
+  { if (l->type == Function)
+    { l = l->next;
+      continue;
     }
+    out_strw(out,scope_name(list,name),-10);
+    out_str(out,"  ");
+    out_intw(out,list->depth,-12);
+    out_str(out,"  ");
+    out_strw(out,l->name,-7);
+    out_str(out,"  ");
+    out_str(out,dbgExpType(l->type));
+    out_char(out,'\n');
+    l = l->next;
   }
 }
 
@@ -404,10 +625,10 @@ static void fnparam_and_local_print_stream(ScopeList list)
 
 /* print function parameters and local variables */
 void printFnParamAndLocals ( FILE * listing )
-{ fprintf(listing,"Scope Name  Nested Level  ID Name  Data Type\n");
-  fprintf(listing,"----------  ------------  -------  ---------\n");
-  // implicit parameter setting
-  stream = listing;
-  scope_level = 0;
+{ // implicit parameter setting
+  stream = out_to(listing);
+  out_str(stream,"Scope Name  Nested Level  ID Name  Data Type\n");
+  out_str(stream,"----------  ------------  -------  ---------\n");
   scope_traverse(globalScope, fnparam_and_local_print_stream);
+  out_flush(stream);
 }
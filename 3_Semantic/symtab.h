@@ -11,27 +11,40 @@
 
 #include "globals.h"
 
-/* HASHSIZE is the size of the hash table */
+/* HASHSIZE is the number of buckets that order
+ * the symbols of a scope in the listing
+ */
 #define HASHSIZE 211
 
-/* Maximum number of the parameters */
-#define MAXPARAM 10
-
-/* the list of line numbers of the source 
- * code in which a variable is referenced
+/* the line numbers of the source code in which
+ * a variable is referenced, in order: each is kept
+ * as its difference from the one before, in one to
+ * five bytes, see st_appendline
  */
-typedef struct LineListRec
-   { int lineno;
-     struct LineListRec * next;
-   } * LineList;
+typedef struct
+   { unsigned char * bytes;
+     int length; /* bytes used */
+     int capacity;
+     int count; /* line numbers */
+     int last; /* last line number appended */
+   } LineList;
+
+/* Cursor over the line numbers of a symbol */
+typedef struct
+   { const unsigned char * next;
+     const unsigned char * end;
+     int lineno;
+   } LineCursor;
+
+typedef struct
+  { ExpType type;
+    char * name;
+  } ParamInfo;
 
 typedef struct
   { ExpType retn;
     int numparam;
-    struct {
-      ExpType type;
-      char * name;
-    } params[MAXPARAM];
+    ParamInfo * params; /* numparam of them */
   } FunctionInfo;
 
 /* The record in the bucket lists for
@@ -47,16 +60,24 @@ typedef struct BucketListRec
      LineList lines;
      int memloc ; /* memory location for variable */
      FunctionInfo * fninfo;
-     struct BucketListRec * next;
+     struct BucketListRec * next; /* next symbol of the scope */
    } * BucketList;
 
 /* The list of ID scopes.
+ * Names of scopes and variables are interned,
+ * so they are compared by pointer.
  */
 typedef struct ScopeListRec
-   { char * name;
-     BucketList bucket[HASHSIZE];
+   { char * name; /* NULL for a block, see lineno */
+     int lineno, num; /* a block is the num-th one on line lineno */
+     int depth; /* nesting, 0 for the global scope */
+     BucketList * slots; /* open addressing, size of them */
+     int size; /* a power of two, 0 until the first symbol */
+     int count;
+     BucketList symbols; /* newest first, until printed */
      struct ScopeListRec * parent;  // parent node
      struct ScopeListRec * child;   // first child
+     struct ScopeListRec * last;    // last child
      struct ScopeListRec * next;    // linked list, siblings.
    } * ScopeList;
 
@@ -67,47 +88,74 @@ typedef struct
      BucketList bucket;
    } SymAddr;
 
-/* Procedure for initializing global scope.
+/* Procedure for initializing global scope; returns
+ * the next memory location, or -1 if out of memory.
  */
 int global_init ( void );
 
+/* Function global_keep builds the global scope
+ * with the predefined functions now and keeps it:
+ * global_init then puts it back as it was built
+ * here instead of building it again, which needs
+ * the memory of the arena up to this point and the
+ * names kept, until global_drop; returns FALSE if
+ * out of memory, keeping nothing
+ */
+int global_keep ( void );
+
+/* Procedure global_drop makes global_init build
+ * the global scope again
+ */
+void global_drop ( void );
+
 /* Get global scope.
  */
 ScopeList global_scope( void );
 
-/* Find scope. */
+/* Find named scope, for printing and debugging. */
 ScopeList scope_find ( char * scope );
 
 /* Search identity from given record. */
 BucketList scope_search ( ScopeList record, char * name );
 
-/* Insert new scope to specified parent. */
-int scope_insert ( char * parent, char * name );
+/* Insert new scope to specified parent, one level
+ * deeper; name is NULL for a block. Returns the
+ * scope, or NULL if out of memory.
+ */
+ScopeList scope_insert ( ScopeList parent, char * name );
 
 /* Function st_lookup returns the bucket pointer
  * of a variable or 0 if not found.
  */
-SymAddr st_lookup ( char * scope, char * name );
+SymAddr st_lookup ( ScopeList scope, char * name );
 
 /* Function st_lookup_excluding_parent returns the bucket pointer
  * of variable or 0 if not found,
  * only in the specified scope (excluding parent).
  */
-SymAddr st_lookup_excluding_parent ( char * scope, char * name );
+SymAddr st_lookup_excluding_parent ( ScopeList scope, char * name );
 
 /* Procedure st_insert inserts line numbers and
  * memory locations into the symbol table
  * loc = memory location is inserted only the
  * first time, otherwise ignored.
- * Return 1 for success, 0 for scope not found.
+ * Returns the symbol, or NULL if out of memory.
  */
 BucketList st_insert( ScopeList scope, char * name, ExpType type, int size, int lineno, int loc );
 
-/* Append new line list to the given bucket. */
+/* Append new line number to the given bucket. */
 void st_appendline ( BucketList bucket, int lineno );
 
-/* Add function infos to bucket */
-void st_appendfn ( BucketList bucket, TreeNode * node );
+/* Start cursor c at the first line number of bucket.
+ * Function st_nextline then sets c->lineno to each
+ * line number in turn, and returns 0 after the last.
+ */
+void st_firstline ( BucketList bucket, LineCursor * c );
+int st_nextline ( LineCursor * c );
+
+/* Add function infos to bucket; returns FALSE if
+ * out of memory, leaving bucket without them */
+int st_appendfn ( BucketList bucket, TreeNode node );
 
 /* Procedure printSymTab prints a formatted 
  * listing of the symbol table contents 
@@ -8,12 +8,11 @@
 
 #include "globals.h"
 #include "util.h"
+#include "outbuf.h"
 #include "y.tab.h"
 
-/* Procedure printToken prints a token 
- * and its lexeme to the listing file
- */
-void printToken( TokenType token, const char* tokenString )
+/* putToken writes a token and its lexeme to out */
+static void putToken( OutBuf * out, TokenType token, const char* tokenString )
 { switch (token)
   { case IF:
     case ELSE:
@@ -21,46 +20,68 @@ void printToken( TokenType token, const char* tokenString )
     case RETURN:
     case INT:
     case VOID:
-      fprintf(listing,
-         "reserved word: %s\n",tokenString);
+      out_str(out,"reserved word: ");
+      out_str(out,tokenString);
+      out_char(out,'\n');
       break;
-    case ASSIGN: fprintf(listing,"=\n"); break;
-    case EQ: fprintf(listing,"==\n"); break;
-    case NE: fprintf(listing,"!=\n"); break;
-    case LT: fprintf(listing,"<\n"); break;
-    case LE: fprintf(listing, "<=\n"); break;
-    case GT: fprintf(listing, ">\n"); break;
-    case GE: fprintf(listing, ">=\n"); break;
-    case LPAREN: fprintf(listing,"(\n"); break;
-    case RPAREN: fprintf(listing,")\n"); break;
-    case LBRACE: fprintf(listing, "[\n"); break;
-    case RBRACE: fprintf(listing, "]\n"); break;
-    case LCURLY: fprintf(listing, "{\n"); break;
-    case RCURLY: fprintf(listing, "}\n"); break;
-    case SEMI: fprintf(listing,";\n"); break;
-    case COMMA: fprintf(listing, ",\n"); break;
-    case PLUS: fprintf(listing,"+\n"); break;
-    case MINUS: fprintf(listing,"-\n"); break;
-    case TIMES: fprintf(listing,"*\n"); break;
-    case OVER: fprintf(listing,"/\n"); break;
-    case ENDFILE: fprintf(listing,"EOF\n"); break;
+    case ASSIGN: out_str(out,"=\n"); break;
+    case EQ: out_str(out,"==\n"); break;
+    case NE: out_str(out,"!=\n"); break;
+    case LT: out_str(out,"<\n"); break;
+    case LE: out_str(out,"<=\n"); break;
+    case GT: out_str(out,">\n"); break;
+    case GE: out_str(out,">=\n"); break;
+    case LPAREN: out_str(out,"(\n"); break;
+    case RPAREN: out_str(out,")\n"); break;
+    case LBRACE: out_str(out,"[\n"); break;
+    case RBRACE: out_str(out,"]\n"); break;
+    case LCURLY: out_str(out,"{\n"); break;
+    case RCURLY: out_str(out,"}\n"); break;
+    case SEMI: out_str(out,";\n"); break;
+    case COMMA: out_str(out,",\n"); break;
+    case PLUS: out_str(out,"+\n"); break;
+    case MINUS: out_str(out,"-\n"); break;
+    case TIMES: out_str(out,"*\n"); break;
+    case OVER: out_str(out,"/\n"); break;
+    case ENDFILE: out_str(out,"EOF\n"); break;
     case NUM:
-      fprintf(listing,
-          "NUM, val= %s\n",tokenString);
+      out_str(out,"NUM, val= ");
+      out_str(out,tokenString);
+      out_char(out,'\n');
       break;
     case ID:
-      fprintf(listing,
-          "ID, name= %s\n",tokenString);
+      out_str(out,"ID, name= ");
+      out_str(out,tokenString);
+      out_char(out,'\n');
       break;
     case ERROR:
-      fprintf(listing,
-          "ERROR: %s\n",tokenString);
+      out_str(out,"ERROR: ");
+      out_str(out,tokenString);
+      out_char(out,'\n');
       break;
     default: /* should never happen */
-      fprintf(listing,"Unknown token: %d\n",token);
+      out_str(out,"Unknown token: ");
+      out_int(out,token);
+      out_char(out,'\n');
   }
 }
 
+/* Procedure fprintToken prints a token 
+ * and its lexeme to the file out
+ */
+void fprintToken( FILE * out, TokenType token, const char* tokenString )
+{ OutBuf * buf = out_to(out);
+  putToken(buf,token,tokenString);
+  out_flush(buf);
+}
+
+/* Procedure printToken prints a token 
+ * and its lexeme to the listing file
+ */
+void printToken( TokenType token, const char* tokenString )
+{ fprintToken(listing,token,tokenString);
+}
+
 
 /* Make expression type as string for printing. */
 const char * dbgExpType(ExpType token)
@@ -83,91 +104,203 @@ const char * dbgExpType(ExpType token)
 /* Procedure printExpType prints a type
  */
 void printExpType(ExpType token)
-{ 
-  fprintf(listing, "%s", dbgExpType(token));
+{ OutBuf * out = out_to(listing);
+  out_str(out,dbgExpType(token));
+  out_flush(out);
 }
 
-/* Function newDeclNode creates a new declaration
- * node for syntax tree construction
+/* growAst resizes the pools of a to cap nodes;
+   returns FALSE if out of memory */
+static int growAst(Ast * a, int cap)
+{ NodeHot * hot = realloc(a->hot, cap * sizeof(NodeHot));
+  int * pos = realloc(a->pos, cap * sizeof(int));
+  NodeAttr * attr = realloc(a->attr, cap * sizeof(NodeAttr));
+  if (hot) a->hot = hot;
+  if (pos) a->pos = pos;
+  if (attr) a->attr = attr;
+  if (!hot || !pos || !attr)
+    return FALSE;
+  a->capacity = cap;
+  return TRUE;
+}
+
+/* newNodeIn takes the next node of a, cleared;
+   a has room for it */
+static TreeNode newNodeIn(Ast * a)
+{ TreeNode t = a->count++;
+  memset(&a->hot[t],0,sizeof(NodeHot));
+  a->pos[t] = 0;
+  a->attr[t].name = NULL;
+  return t;
+}
+
+/* Function newAst returns an empty syntax tree,
+ * or NULL if out of memory
  */
-TreeNode * newDeclNode(DeclKind kind)
-{ TreeNode * t = (TreeNode *) malloc(sizeof(TreeNode));
-  int i;
-  if (t==NULL)
-    fprintf(listing,"Out of memory error at line %d\n",lineno);
-  else {
-    for (i=0;i<MAXCHILDREN;i++) t->child[i] = NULL;
-    t->sibling = NULL;
-    t->nodekind = DeclK;
-    t->kind.decl = kind;
-    t->lineno = lineno;
+Ast * newAst(void)
+{ Ast * a = (Ast *) calloc(1,sizeof(Ast));
+  if (a == NULL)
+    return NULL;
+  if (!growAst(a,1024))
+  { freeAst(a);
+    return NULL;
   }
+  /* node NULLNODE stays cleared and is never written */
+  newNodeIn(a);
+  return a;
+}
+
+/* Procedure freeAst releases a syntax tree */
+void freeAst(Ast * a)
+{ if (a == NULL)
+    return;
+  free(a->hot);
+  free(a->pos);
+  free(a->attr);
+  free(a->sym);
+  free(a);
+}
+
+/* Procedure resetAst empties a syntax tree */
+void resetAst(Ast * a)
+{ a->count = 1;
+}
+
+/* newNode makes a node of the given kinds in ast,
+   with no children, siblings or type */
+static TreeNode newNode(NodeKind nodekind, int kind)
+{ TreeNode t;
+  if (ast->count == ast->capacity && !growAst(ast,ast->capacity*2))
+  { fprintf(listing,"Out of memory error at line %d\n",lineOf(srcpos));
+    return NULLNODE;
+  }
+  t = newNodeIn(ast);
+  NODEKIND(t) = nodekind;
+  KIND(t) = kind;
+  POS(t) = srcpos;
   return t;
 }
 
+/* Function newDeclNode creates a new declaration
+ * node for syntax tree construction
+ */
+TreeNode newDeclNode(DeclKind kind)
+{ return newNode(DeclK,kind);
+}
+
 /* Function newStmtNode creates a new statement
  * node for syntax tree construction
  */
-TreeNode * newStmtNode(StmtKind kind)
-{ TreeNode * t = (TreeNode *) malloc(sizeof(TreeNode));
-  int i;
-  if (t==NULL)
-    fprintf(listing,"Out of memory error at line %d\n",lineno);
-  else {
-    for (i=0;i<MAXCHILDREN;i++) t->child[i] = NULL;
-    t->sibling = NULL;
-    t->nodekind = StmtK;
-    t->kind.stmt = kind;
-    t->lineno = lineno;
-  }
-  return t;
+TreeNode newStmtNode(StmtKind kind)
+{ return newNode(StmtK,kind);
 }
 
 /* Function newExpNode creates a new expression 
  * node for syntax tree construction
  */
-TreeNode * newExpNode(ExpKind kind)
-{ TreeNode * t = (TreeNode *) malloc(sizeof(TreeNode));
-  int i;
-  if (t==NULL)
-    fprintf(listing,"Out of memory error at line %d\n",lineno);
-  else {
-    for (i=0;i<MAXCHILDREN;i++) t->child[i] = NULL;
-    t->sibling = NULL;
-    t->nodekind = ExpK;
-    t->kind.exp = kind;
-    t->lineno = lineno;
-    t->type = Void;
-  }
-  return t;
+TreeNode newExpNode(ExpKind kind)
+{ return newNode(ExpK,kind);
 }
 
 
 /* Function newOpNode creates a new operation
  * node for syntax tree construction
  */
-TreeNode * newOpNode(TokenType optype)
-{ TreeNode * t = newExpNode(OpK);
-  if (t != NULL)
-    t->attr.op = optype;
+TreeNode newOpNode(TokenType optype)
+{ TreeNode t = newExpNode(OpK);
+  if (t != NULLNODE)
+    ATTR(t).op = optype;
   return t;
 }
 
 /* Function copyString allocates and makes a new
- * copy of an existing string
+ * copy of an existing string in the arena
  */
 char * copyString(char * s)
 { int n;
   char * t;
   if (s==NULL) return NULL;
   n = strlen(s)+1;
-  t = malloc(n);
+  t = arena_alloc(arena,n);
   if (t==NULL)
-    fprintf(listing,"Out of memory error at line %d\n",lineno);
+    fprintf(listing,"Out of memory error at line %d\n",lineOf(srcpos));
   else strcpy(t,s);
   return t;
 }
 
+/* Function internString returns the interned
+ * name of a string
+ */
+char * internString(char * s)
+{ char * t = intern(names,s,strlen(s));
+  if (t==NULL)
+    fprintf(listing,"Out of memory error at line %d\n",lineOf(srcpos));
+  return t;
+}
+
+/* Function internSlice returns the interned
+ * name of a lexeme in the source map
+ */
+char * internSlice(TokenSlice slice)
+{ char * t = intern(names,source->text+slice.offset,slice.length);
+  if (t==NULL)
+    fprintf(listing,"Out of memory error at line %d\n",lineOf(srcpos));
+  return t;
+}
+
+/* Function sliceText copies a lexeme into buf,
+ * truncated to size-1 characters, and returns buf
+ */
+char * sliceText(TokenSlice slice, char * buf, int size)
+{ return srcmap_text(source,slice,buf,size);
+}
+
+/* Function sliceNum returns the value of
+ * a number lexeme in the source map
+ */
+int sliceNum(TokenSlice slice)
+{ const char * p = source->text+slice.offset;
+  int i, val = 0;
+  for (i=0;i<slice.length && isdigit((unsigned char) p[i]);i++)
+    val = val*10 + (p[i]-'0');
+  return val;
+}
+
+/* Function lineOf returns the source line
+ * of an offset
+ */
+int lineOf(int pos)
+{ return srcmap_line(source,pos);
+}
+
+/* Function columnOf returns the source
+ * column of an offset
+ */
+int columnOf(int pos)
+{ return srcmap_column(source,pos);
+}
+
+/* Procedure noteError adds an error to errors */
+void noteError(int line, int column, const char * message, const char * name)
+{ SourceError * e;
+  if (errors == NULL)
+    return;
+  if (errors->count == errors->capacity)
+  { int cap = errors->capacity ? errors->capacity * 2 : 16;
+    e = (SourceError *) realloc(errors->items, cap * sizeof(SourceError));
+    /* the listing still has it */
+    if (e == NULL)
+      return;
+    errors->items = e;
+    errors->capacity = cap;
+  }
+  e = &errors->items[errors->count++];
+  e->line = line;
+  e->column = column;
+  e->message = message;
+  e->name = name;
+}
+
 /* Fill random string */
 void randomFill(char * str, int size)
 { int i;
@@ -177,122 +310,169 @@ void randomFill(char * str, int size)
     str[i] = rand() % LIBSIZE;
 }
 
-/* Variable indentno is used by printTree to
- * store current number of spaces to indent
+/* Function pushFrame pushes node t on the stack s,
+ * to visit its children from the first; returns FALSE
+ * if out of memory
  */
-static int indentno = 0;
-
-/* macros to increase/decrease indentation */
-#define INDENT indentno+=2
-#define UNINDENT indentno-=2
-
-/* printSpaces indents by printing spaces */
-static void printSpaces(void)
-{ int i;
-  for (i=0;i<indentno;i++)
-    fprintf(listing," ");
+int pushFrame(TreeStack * s, TreeNode t)
+{ if (s->top + 1 == s->capacity)
+  { int cap = s->capacity ? s->capacity * 2 : 64;
+    TreeFrame * frames = realloc(s->frames, cap * sizeof(TreeFrame));
+    if (frames == NULL)
+    { fprintf(listing,"Out of memory error in traversal\n");
+      Error = TRUE;
+      return FALSE;
+    }
+    s->frames = frames;
+    s->capacity = cap;
+  }
+  s->top++;
+  s->frames[s->top].node = t;
+  s->frames[s->top].child = 0;
+  return TRUE;
 }
 
-static int printDeclVar(TreeNode * tree)
+static int putDeclVar(OutBuf * out, TreeNode tree)
 { int flag = 1;
-  fprintf(listing,"name : %s, type : ",tree->attr.name);
-  printExpType(tree->type);
-  if (tree->child[0] != NULL) {
-    if (tree->child[0]->attr.val != -1)
-      fprintf(listing,"[%d]",tree->child[0]->attr.val);
+  out_str(out,"name : ");
+  out_str(out,ATTR(tree).name);
+  out_str(out,", type : ");
+  out_str(out,dbgExpType(TYPE(tree)));
+  if (CHILD(tree,0) != NULLNODE) {
+    if (ATTR(CHILD(tree,0)).val != -1) {
+      out_char(out,'[');
+      out_int(out,ATTR(CHILD(tree,0)).val);
+      out_char(out,']');
+    }
     else
-      fprintf(listing, "[]");
+      out_str(out,"[]");
     flag = 0;
   }
-  fprintf(listing,"\n");
+  out_char(out,'\n');
+  return flag;
+}
+
+/* putNode writes the line of printTree for one
+   node, indented; returns whether its children
+   are printed */
+static int putNode( OutBuf * out, TreeNode tree, int indent )
+{ int flag = 1;
+  out_spaces(out,indent);
+  switch (NODEKIND(tree))
+  { case DeclK:
+      switch (KIND(tree)) {
+        case ParamK:
+          out_str(out,"Single parameter, ");
+          flag = putDeclVar(out,tree);
+          break;
+        case VarK:
+          out_str(out,"Var declaration, ");
+          flag = putDeclVar(out,tree);
+          break;
+        case FnK:
+          out_str(out,"Function declaration, name : ");
+          out_str(out,ATTR(tree).name);
+          out_str(out,", return type: ");
+          out_str(out,dbgExpType(TYPE(tree)));
+          out_char(out,'\n');
+          break;
+        default:
+          out_str(out,"Unknown DeclNode kind\n");
+          break;
+      }
+      break;
+    case StmtK:
+      switch (KIND(tree)) {
+        case CompK:
+          out_str(out,"Compund Statement :\n");
+          break;
+        case IfK:
+          out_str(out,"If (condition) (body)");
+          if (CHILD(tree,2) != NULLNODE)
+            out_str(out," (else)");
+          out_char(out,'\n');
+          break;
+        case WhileK:
+          out_str(out,"While (condition) (body)\n");
+          break;
+        case ReturnK:
+          out_str(out,"Return : \n");
+          break;
+        default:
+          out_str(out,"Unknown StmtNode kind\n");
+          break;
+      }
+      break;
+    case ExpK:
+      switch (KIND(tree)) {
+        case AssignK:
+          out_str(out,"Assign : (destination) (source)\n");
+          break;
+        case OpK:
+          out_str(out,"Op : ");
+          putToken(out,ATTR(tree).op,"\0");
+          break;
+        case ConstK:
+          out_str(out,"Const : ");
+          out_int(out,ATTR(tree).val);
+          out_char(out,'\n');
+          break;
+        case IdK:
+          out_str(out,"Id : ");
+          out_str(out,ATTR(tree).name);
+          out_char(out,'\n');
+          break;
+        case CallK:
+          out_str(out,"Call, name : ");
+          out_str(out,ATTR(tree).name);
+          out_str(out,", with arguments below\n");
+          break;
+        case IdxK:
+          out_str(out,"Indexing : (expression)\n");
+          break;
+        default:
+          out_str(out,"Unknown ExpNode kind\n");
+          break;
+      }
+      break;
+    default:
+      out_str(out,"Unknown node kind\n");
+  }
   return flag;
 }
 
 /* procedure printTree prints a syntax tree to the 
- * listing file using indentation to indicate subtrees
+ * listing file using indentation to indicate subtrees;
+ * the path to the current node is kept on a TreeStack,
+ * so that deep trees do not exhaust the call stack
  */
-void printTree( TreeNode * tree )
-{ int i, flag;
-  INDENT;
-  while (tree != NULL) {
-    printSpaces();
-    flag = 1;
-    switch (tree->nodekind)
-    { case DeclK:
-        switch (tree->kind.decl) {
-          case ParamK:
-            fprintf(listing,"Single parameter, ");
-            flag = printDeclVar(tree);
-            break;
-          case VarK:
-            fprintf(listing,"Var declaration, ");
-            flag = printDeclVar(tree);
-            break;
-          case FnK:
-            fprintf(listing,"Function declaration, name : %s, return type: ",tree->attr.name);
-            printExpType(tree->type);
-            fprintf(listing,"\n");
-            break;
-          default:
-            fprintf(listing,"Unknown DeclNode kind\n");
-            break;
-        }
-        break;
-      case StmtK:
-        switch (tree->kind.stmt) {
-          case CompK:
-            fprintf(listing,"Compund Statement :\n");
-            break;
-          case IfK:
-            fprintf(listing,"If (condition) (body)");
-            if (tree->child[2] != NULL)
-              fprintf(listing," (else)");
-            fprintf(listing,"\n");
-            break;
-          case WhileK:
-            fprintf(listing,"While (condition) (body)\n");
-            break;
-          case ReturnK:
-            fprintf(listing,"Return : \n");
-            break;
-          default:
-            fprintf(listing,"Unknown StmtNode kind\n");
-            break;
-        }
-        break;
-      case ExpK:
-        switch (tree->kind.exp) {
-          case AssignK:
-            fprintf(listing,"Assign : (destination) (source)\n");
-            break;
-          case OpK:
-            fprintf(listing,"Op : ");
-            printToken(tree->attr.op,"\0");
-            break;
-          case ConstK:
-            fprintf(listing,"Const : %d\n",tree->attr.val);
-            break;
-          case IdK:
-            fprintf(listing,"Id : %s\n",tree->attr.name);
-            break;
-          case CallK:
-            fprintf(listing,"Call, name : %s, with arguments below\n",tree->attr.name);
-            break;
-          case IdxK:
-            fprintf(listing,"Indexing : (expression)\n");
-            break;
-          default:
-            fprintf(listing,"Unknown ExpNode kind\n");
-            break;
-        }
+void printTree( TreeNode tree )
+{ OutBuf * out = out_to(listing);
+  TreeStack stack = { NULL, -1, 0 };
+  if (tree != NULLNODE && pushFrame(&stack,tree))
+  { if (!putNode(out,tree,2))
+      stack.frames[0].child = MAXCHILDREN;
+  }
+  while (stack.top >= 0)
+  { TreeFrame * f = &stack.frames[stack.top];
+    if (f->child < MAXCHILDREN)
+    { TreeNode c = CHILD(f->node,f->child++);
+      if (c == NULLNODE)
+        continue;
+      if (!pushFrame(&stack,c))
         break;
-      default:
-        fprintf(listing,"Unknown node kind\n");
+      f = &stack.frames[stack.top];
+    }
+    else if ((f->node = SIBLING(f->node)) != NULLNODE)
+      f->child = 0;
+    else
+    { stack.top--;
+      continue;
     }
-    if (flag)
-      for (i=0;i<MAXCHILDREN;i++)
-          printTree(tree->child[i]);
-    tree = tree->sibling;
+    /* a node is printed when it gets its frame */
+    if (!putNode(out,f->node,2*(stack.top+1)))
+      f->child = MAXCHILDREN;
   }
-  UNINDENT;
+  free(stack.frames);
+  out_flush(out);
 }
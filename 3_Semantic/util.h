@@ -8,6 +8,11 @@
 #ifndef _UTIL_H_
 #define _UTIL_H_
 
+/* Procedure fprintToken prints a token 
+ * and its lexeme to the file out
+ */
+void fprintToken( FILE *, TokenType, const char* );
+
 /* Procedure printToken prints a token 
  * and its lexeme to the listing file
  */
@@ -20,37 +25,111 @@ const char * dbgExpType(ExpType);
  */
 void printExpType(ExpType);
 
+/* Function newAst returns an empty syntax tree,
+ * or NULL if out of memory
+ */
+Ast * newAst(void);
+
+/* Procedure freeAst releases a syntax tree */
+void freeAst(Ast *);
+
+/* Procedure resetAst empties a syntax tree,
+ * keeping its pools for the next one
+ */
+void resetAst(Ast *);
+
 /* Function newDeclNode creates a new declaration
  * node for syntax tree construction
  */
-TreeNode * newDeclNode(DeclKind);
+TreeNode newDeclNode(DeclKind);
 
 /* Function newStmtNode creates a new statement
  * node for syntax tree construction
  */
-TreeNode * newStmtNode(StmtKind);
+TreeNode newStmtNode(StmtKind);
 
 /* Function newExpNode creates a new expression 
  * node for syntax tree construction
  */
-TreeNode * newExpNode(ExpKind);
+TreeNode newExpNode(ExpKind);
 
 /* Function newOpNode creates a new operation
  * node for syntax tree construction
  */
-TreeNode * newOpNode(TokenType);
+TreeNode newOpNode(TokenType);
 
 /* Function copyString allocates and makes a new
- * copy of an existing string
+ * copy of an existing string in the arena
  */
 char * copyString( char * );
 
+/* Function internString returns the interned
+ * name of a string
+ */
+char * internString( char * );
+
+/* Function internSlice returns the interned
+ * name of a lexeme in the source map
+ */
+char * internSlice( TokenSlice );
+
+/* Function sliceText copies a lexeme into buf,
+ * truncated to size-1 characters, and returns buf
+ */
+char * sliceText( TokenSlice, char *, int );
+
+/* Function sliceNum returns the value of
+ * a number lexeme in the source map
+ */
+int sliceNum( TokenSlice );
+
+/* Function lineOf returns the source line
+ * of an offset, from the line index of the
+ * source map
+ */
+int lineOf( int );
+
+/* Function columnOf returns the source
+ * column of an offset
+ */
+int columnOf( int );
+
+/* Procedure noteError adds the error at line and
+ * column, 0 if unknown, to errors, if they are kept;
+ * the name is that of an identifier, or NULL
+ */
+void noteError( int line, int column, const char * message, const char * name );
+
 /* Fill random string. */
 void randomFill(char *, int);
 
+/* A TreeFrame is a node on the path of a traversal,
+ * with the next of its children to visit
+ */
+typedef struct
+   { TreeNode node;
+     int child;
+   } TreeFrame;
+
+/* A TreeStack holds the path of a traversal on the
+ * heap, one frame per level of nesting; start it as
+ * { NULL, -1, 0 } and free frames when done
+ */
+typedef struct
+   { TreeFrame * frames;
+     int top; /* index of the current frame */
+     int capacity;
+   } TreeStack;
+
+/* Function pushFrame pushes node t on the stack s,
+ * to visit its children from the first; returns FALSE
+ * if out of memory
+ */
+int pushFrame(TreeStack * s, TreeNode t);
+
 /* procedure printTree prints a syntax tree to the 
  * listing file using indentation to indicate subtrees
  */
-void printTree( TreeNode * );
+void printTree( TreeNode );
 
 #endif